@@ -1,5 +1,6 @@
 #include "cli.h"
 #include "ubasic.h"
+#include "numconv.h"
 #include "../hardware/usart.h"
 
 /* Example Scripts for demo command ---------------------------------------------------------*/
@@ -254,7 +255,7 @@ void ubasic_cli(void)
     {
       if (serial_input_available())
       {
-        serial_input(statement,sizeof(statement));
+        serial_input(statement,sizeof(statement)-1);
         if (strstr(statement,"kill"))
         {
             // enter programming mode
@@ -271,7 +272,7 @@ void ubasic_cli(void)
   {
     if (serial_input_available())
     {
-      serial_input(statement,sizeof(statement));
+      serial_input(statement,sizeof(statement)-1);
 
       if (strstr(statement,"prog"))
       {
@@ -347,6 +348,26 @@ void ubasic_cli(void)
         return;
       }
 #endif
+#if defined(VARIABLE_TYPE_ARRAY)
+      else if (strstr(statement,"mem"))
+      {
+          // array heap usage and fragmentation
+        static const char * const label[4] =
+          { "arrays: used ", ", free ", ", largest ", ", free blocks " };
+        uint16_t stats[4];
+        char n[NUMCONV_MAXLEN];
+        print_serial("mem\n");
+        ubasic_array_stats(&stats[0], &stats[1], &stats[2], &stats[3]);
+        for (uint8_t i=0; i<4; i++)
+        {
+          print_serial((char *) label[i]);
+          numconv_dec(n, stats[i]);
+          print_serial(n);
+        }
+        print_serial("\n>");
+        return;
+      }
+#endif
 #if defined(UBASIC_SCRIPT_HAVE_STORE_VARS_IN_FLASH)
       else if (strstr(statement,"flash"))
       {
@@ -366,11 +387,11 @@ void ubasic_cli(void)
           while (script[strlen(script)-1]==' ' || script[strlen(script)-1]=='\t')
             script[strlen(script)-1]='\0';
           if (script[strlen(script)-1] != '\n' && script[strlen(script)-1] != ';')
-            sprintf(&script[strlen(script)], "\n");
+            strcat(script, "\n");
         }
         char *s = statement;
         while (*s==' ') s++;
-        sprintf(&script[strlen(script)], s);
+        strcat(script, s);
         print_serial(s);
         print_serial("\n>");
       }
@@ -41,14 +41,24 @@
 /* Storage and arithmetics */
 #undef  VARIABLE_STORAGE_INT16
 #undef  VARIABLE_STORAGE_INT32
+#undef  VARIABLE_STORAGE_INT64
 #undef  VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8
 #undef  VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10
+#undef  VARIABLE_TYPE_FLOAT_AS_FIXEDPT_32_32
+#undef  VARIABLE_TYPE_FLOAT_NATIVE
+#undef  FIXEDPT_TRIG_TABLE
+#undef  FIXEDPT_TRIG_CORDIC
+#undef  FIXEDPT_DIV_32
 #undef  VARIABLE_TYPE_STRING
+#undef  VARIABLE_TYPE_STRING_ARRAY
 #undef  VARIABLE_TYPE_ARRAY
+#undef  UBASIC_SCRIPT_HAVE_FFT
+#undef  UBASIC_SCRIPT_HAVE_BIT_OPERATIONS
 #undef  UBASIC_SCRIPT_HAVE_DEMO_SCRIPTS
 
 /* Microcontroller related functionality */
 #undef  UBASIC_SCRIPT_HAVE_RANDOM_NUMBER_GENERATOR
+#undef  RANDOM_FIXED_SEED
 #undef  UBASIC_SCRIPT_HAVE_PWM_CHANNELS
 #undef  UBASIC_SCRIPT_HAVE_GPIO
 #undef  UBASIC_SCRIPT_HAVE_TICTOC
@@ -64,7 +74,11 @@
   *   UBASIC-PLUS: Start
   *
   */
-/* default storage for all numeric values */
+/* default storage for all numeric values:
+    VARIABLE_STORAGE_INT64 doubles variables, arrays and their FLASH images,
+    for hosts that need more range and precision, e.g. long running
+    integrators. It needs a compiler with __int128 for the intermediate
+    results, and its fixed point floats are VARIABLE_TYPE_FLOAT_AS_FIXEDPT_32_32 */
 #define VARIABLE_STORAGE_INT32
 
 /* defines the representation of floating point numbers as fixed points:
@@ -73,15 +87,49 @@
     consumes lots of memory) */
 #define VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8
 
+/* or keeps them as floats, instead of any of the fixed points above:
+    VARIABLE_TYPE_FLOAT_NATIVE stores float with VARIABLE_STORAGE_INT32 and
+    double with VARIABLE_STORAGE_INT64, for hosts and Cortex M4F where the
+    FPU is faster than the fixed point multiplies and divides. Array
+    headers and packed arrays share the entries of the array storage with
+    the floats, but are only ever read and written as integers */
+
+/* how sin, cos and tan are computed in fixed point:
+    none of the two - polynomial of the fixed point library, small but coarse,
+    FIXEDPT_TRIG_TABLE - quarter wave table with linear interpolation, the
+      fastest and most accurate, 514 bytes of flash shared with fft,
+    FIXEDPT_TRIG_CORDIC - 16 shift and add rotations, accurate without any
+      multiplication, 64 bytes of flash */
+#define FIXEDPT_TRIG_TABLE
+
+/* fixed point division without the double width division: one single width
+    division and a shift and subtract step per fraction bit, with the same
+    quotient. Cortex M0 has no divider, and this replaces __aeabi_ldivmod
+    with the much shorter __aeabi_uidivmod */
+#define FIXEDPT_DIV_32
+
 /* This many one-letter variables UBASIC supports */
 #define MAX_VARNUM 26
 
 /* have numeric arrays and set their storage to this many VARIABLE_TYPE entries */
 #define VARIABLE_TYPE_ARRAY 64
 
+/* have fft and amag on numeric arrays: the twiddle factors take 514 bytes
+    of flash, unless they are shared with FIXEDPT_TRIG_TABLE */
+#define UBASIC_SCRIPT_HAVE_FFT
+
+/* have shl, shr, bit, setbit, clrbit, popcount and clz on the whole part of
+    numbers: popcount and clz are __builtin_popcount and __builtin_clz of gcc,
+    single instructions where the core has them (CLZ from Cortex M3 on) */
+#define UBASIC_SCRIPT_HAVE_BIT_OPERATIONS
+
 /* have strings and related functions */
 #define VARIABLE_TYPE_STRING
 
+/* have string arrays and set their storage to this many entries: an array
+    of n strings takes n+1 entries of 2 bytes */
+#define VARIABLE_TYPE_STRING_ARRAY 32
+
 /* can go to sleep: leave UBASIC for other stuff while waiting for timer to expire */
 #define  UBASIC_SCRIPT_HAVE_SLEEP
 
@@ -94,6 +142,14 @@
 /* support for random number generator by micro-controller */
 #define  UBASIC_SCRIPT_HAVE_RANDOM_NUMBER_GENERATOR
 
+/* random numbers come from the xoshiro128** generator, which is seeded from
+    the noise of the internal temperature sensor, and the noise is mixed in
+    again every 2^RANDOM_RESEED_BITS numbers (1 to 31). With RANDOM_FIXED_SEED
+    the generator starts from that seed instead, and repeats the same numbers
+    after every reset, as it always does on boards without ADC */
+// #define  RANDOM_FIXED_SEED  0x2545F491
+#define  RANDOM_RESEED_BITS  16
+
 /* support for direct access to pin inputs and ooutputs */
 #define  UBASIC_SCRIPT_HAVE_GPIO_CHANNELS
 
@@ -131,9 +187,31 @@
  *                      CAN'T TOUCH THIS!
  *
  */
+#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10) || \
+    defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_32_32)
+  #define UBASIC_HAVE_FIXEDPT_FLOATS
+#endif
+#if defined(UBASIC_HAVE_FIXEDPT_FLOATS) || defined(VARIABLE_TYPE_FLOAT_NATIVE)
+  #define UBASIC_HAVE_FLOATS
+#endif
+
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE) && defined(UBASIC_HAVE_FIXEDPT_FLOATS)
+  #error "Select either VARIABLE_TYPE_FLOAT_NATIVE or a fixed point float"
+#endif
+
 #if defined(VARIABLE_STORAGE_INT32)
 
-  #define VARIABLE_TYPE int32_t
+  #if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+    #define VARIABLE_TYPE float
+    #define VARIABLE_TYPE_MAX FLT_MAX
+  #else
+    #define VARIABLE_TYPE int32_t
+    #define VARIABLE_TYPE_MAX INT32_MAX
+  #endif
+
+  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_32_32)
+    #error "32.32 floats need VARIABLE_STORAGE_INT64"
+  #endif
 
   #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
 
@@ -147,6 +225,37 @@
       #error "Only 24.8 and 22.10 floats are currently supported"
     #endif
 
+    #if defined(FIXEDPT_TRIG_TABLE) && defined(FIXEDPT_TRIG_CORDIC)
+      #error "Select only one of FIXEDPT_TRIG_TABLE and FIXEDPT_TRIG_CORDIC"
+    #endif
+
+    #include "fixedptc.h"
+
+  #endif
+
+#elif defined(VARIABLE_STORAGE_INT64)
+
+  #if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+    #define VARIABLE_TYPE double
+    #define VARIABLE_TYPE_MAX DBL_MAX
+  #else
+    #define VARIABLE_TYPE int64_t
+    #define VARIABLE_TYPE_MAX INT64_MAX
+  #endif
+
+  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+    #error "Only 32.32 floats are supported for 64bit Storage"
+  #endif
+
+  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_32_32)
+
+    #define FIXEDPT_BITS 64
+    #define FIXEDPT_WBITS 32
+
+    #if defined(FIXEDPT_TRIG_TABLE) && defined(FIXEDPT_TRIG_CORDIC)
+      #error "Select only one of FIXEDPT_TRIG_TABLE and FIXEDPT_TRIG_CORDIC"
+    #endif
+
     #include "fixedptc.h"
 
   #endif
@@ -154,14 +263,19 @@
 #elif defined(VARIABLE_STORAGE_INT16)
 
   #define VARIABLE_TYPE int16_t
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
-    #error "Fixed Point Floats are Supported for 32bit Storage Only!"
+  #define VARIABLE_TYPE_MAX INT16_MAX
+  #if defined(UBASIC_HAVE_FLOATS)
+    #error "Floats are Supported for 32bit and 64bit Storage Only!"
   #endif
 
 #else
 
-  #error "Only INT32 and INT16 variable types are supported."
+  #error "Only INT64, INT32 and INT16 variable types are supported."
+
+#endif
 
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+  #include "nativefp.h"
 #endif
 
 #define UBASIC_STATUS_RUN   0x80
@@ -185,14 +299,46 @@ typedef union
   } bit;
 } _Status;
 
-#define MAX_STRINGLEN     40
 #define MAX_LABEL_LEN     10
 
 #if defined(VARIABLE_TYPE_STRING)
-#define MAX_STRINGVARLEN  64
+/* size in bytes of the string scratch space (heap) in which all string
+    variables and intermediate results are kept: at most 32767 */
 #define MAX_BUFFERLEN     256
-#define GBGCHECK          100
+/* longest string a literal, variable or string function can produce.
+    Up to 255 string lengths are stored in a single byte, above that
+    in two bytes. Longer strings are truncated. */
+#define MAX_STRINGLEN     40
 #define MAX_SVARNUM       26
+
+#if (MAX_BUFFERLEN > 32767)
+  #error "String heap is addressed using 16bit signed offsets: MAX_BUFFERLEN <= 32767"
+#endif
+#if (MAX_STRINGLEN > 65535) || (MAX_STRINGLEN + 4 > MAX_BUFFERLEN)
+  #error "MAX_STRINGLEN has to fit in the string heap"
+#endif
+#if (MAX_STRINGLEN > 255)
+  #define STRING_LEN_TYPE   uint16_t
+#else
+  #define STRING_LEN_TYPE   uint8_t
+#endif
+#elif defined(VARIABLE_TYPE_STRING_ARRAY)
+  #error "String arrays need VARIABLE_TYPE_STRING"
+#endif
+
+#if defined(UBASIC_SCRIPT_HAVE_FFT) && !defined(VARIABLE_TYPE_ARRAY)
+  #error "FFT needs VARIABLE_TYPE_ARRAY"
+#endif
+
+#if defined(UBASIC_SCRIPT_HAVE_RANDOM_NUMBER_GENERATOR)
+#if (RANDOM_RESEED_BITS < 1) || (RANDOM_RESEED_BITS > 31)
+  #error "RANDOM_RESEED_BITS has to be 1 to 31"
+#endif
+#if (RANDOM_RESEED_BITS > 16)
+  #define RANDOM_COUNT_TYPE   uint32_t
+#else
+  #define RANDOM_COUNT_TYPE   uint16_t
+#endif
 #endif
 
 
@@ -256,7 +402,7 @@ void print_serial(char * msg){;}
 #if defined(UBASIC_SCRIPT_HAVE_INPUT_FROM_SERIAL)
 #define UBASIC_SERIAL_INPUT_MS  50
 uint8_t serial_input_available();
-uint8_t serial_input (char * buffer, uint8_t len);
+uint16_t serial_input (char * buffer, uint16_t len);
 extern volatile uint32_t ubasic_script_wait_for_input_ms;
 extern uint8_t ubasic_script_wait_for_input_expired;
 #endif
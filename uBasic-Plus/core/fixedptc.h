@@ -103,8 +103,12 @@ typedef	__uint128_t fixedptud;
 #define fixedpt_sub(A,B) ((A) - (B))
 #define fixedpt_xmul(A,B)						\
 	((fixedpt)(((fixedptd)(A) * (fixedptd)(B)) >> FIXEDPT_FBITS))
+#if defined(FIXEDPT_DIV_32)
+#define fixedpt_xdiv(A,B)	fixedpt_div((A), (B))
+#else
 #define fixedpt_xdiv(A,B)						\
 	((fixedpt)(((fixedptd)(A) << FIXEDPT_FBITS) / (fixedptd)(B)))
+#endif
 #define fixedpt_fracpart(A) ((fixedpt)(A) & FIXEDPT_FMASK)
 
 #define FIXEDPT_ONE	((fixedpt)((fixedpt)1 << FIXEDPT_FBITS))
@@ -125,12 +129,38 @@ static inline fixedpt fixedpt_mul(fixedpt A, fixedpt B)
 }
 
 
+#if defined(FIXEDPT_DIV_32)
+/*
+ * Divides two fixedpt numbers, returns the result.  The whole part of
+ * |A| / |B| takes one single width division and the FIXEDPT_FBITS fraction
+ * bits are restoring shift and subtract steps on the remainder, so there is
+ * no double width division.  The quotient is the same as that of the double
+ * width division, truncated towards zero and wrapped to fixedpt.
+ */
+static inline fixedpt
+fixedpt_div(fixedpt A, fixedpt B)
+{
+	fixedptu a = (A < 0) ? -(fixedptu)A : (fixedptu)A;
+	fixedptu b = (B < 0) ? -(fixedptu)B : (fixedptu)B;
+	fixedptu q = a / b, r = a - q * b, t;
+	int i;
+
+	for (i = 0; i < FIXEDPT_FBITS; i++) {
+		r <<= 1;
+		t = (r >= b);
+		q = (q << 1) | t;
+		r -= b & -t;
+	}
+	return ((fixedpt)(((A ^ B) < 0) ? -q : q));
+}
+#else
 /* Divides two fixedpt numbers, returns the result. */
 static inline fixedpt
 fixedpt_div(fixedpt A, fixedpt B)
 {
 	return (((fixedptd)A << FIXEDPT_FBITS) / (fixedptd)B);
 }
+#endif
 
 /*
  * Note: adding and substracting fixedpt numbers can be done by using
@@ -143,11 +173,15 @@ fixedpt_div(fixedpt A, fixedpt B)
   * 
   */
 #include <stdlib.h>
-static inline fixedpt str_fixedpt(char * p, uint8_t plen, uint8_t decimal_places)
+static inline fixedpt str_fixedpt(char * p, uint16_t plen, uint8_t decimal_places)
 {
   uint8_t i_minus = *p == '-' ? 1 : 0;
 
+#if FIXEDPT_BITS == 64
+  fixedpt rval = fixedpt_fromint(atoll(p));
+#else
   fixedpt rval = fixedpt_fromint(atoi(p));
+#endif
 
   // find '.': the number is float because it has at least one
   // digit past decimal point
@@ -161,8 +195,10 @@ static inline fixedpt str_fixedpt(char * p, uint8_t plen, uint8_t decimal_places
   // are there any digits left past decimal point
   if ((s-p)<plen)
   {
-    // pick up not more then 'decimal_places':
-    uint16_t  f=0, fpow10=1;
+    // pick up not more then 'decimal_places': the power of ten of
+    // (FIXEDPT_FBITS / 2) decimals fits fixedptu, and f shifted by
+    // FIXEDPT_FBITS does for 32 bit fixedpts
+    fixedptu  f=0, fpow10=1;
     uint8_t   idec=0;
     while ( ((s-p)<plen) && isdigit(*s) && (idec<decimal_places))
     {
@@ -171,10 +207,15 @@ static inline fixedpt str_fixedpt(char * p, uint8_t plen, uint8_t decimal_places
       fpow10 *= 10;
       idec++;
     }
+#if FIXEDPT_BITS == 64
+    f = ((fixedptud)f << FIXEDPT_FBITS) / fpow10;
+#else
+    f = (f << FIXEDPT_FBITS) / fpow10;
+#endif
     if (i_minus)
-      rval -= (f<<FIXEDPT_FBITS)/fpow10;
+      rval -= f;
     else
-      rval += (f<<FIXEDPT_FBITS)/fpow10;
+      rval += f;
   }
 
   return rval;
@@ -258,41 +299,219 @@ fixedpt_cstr(const fixedpt A, const int max_dec)
 }
 
 
-/* Returns the square root of the given number, or -1 in case of error */
+/*
+ * Returns the square root of the given number, or -1 in case of error.
+ * The root of A * 2^FIXEDPT_FBITS is taken bit by bit, two radicand bits
+ * per step, and rounded to nearest: (FIXEDPT_BITS + FIXEDPT_FBITS) / 2
+ * steps of single width shifts, compares and subtractions.
+ */
 static inline fixedpt fixedpt_sqrt(fixedpt A)
 {
-	int invert = 0;
-	int iter = FIXEDPT_FBITS;
-	int l, i;
+	fixedptu a = A, root = 0, rem = 0, t, m;
+	int i;
 
 	if (A < 0)
 		return (-1);
-	if (A == 0 || A == FIXEDPT_ONE)
-		return (A);
-	if (A < FIXEDPT_ONE && A > 6) {
-		invert = 1;
-		A = fixedpt_div(FIXEDPT_ONE, A);
+#if (FIXEDPT_BITS + FIXEDPT_FBITS) & 1
+	/* an odd number of radicand bits: the first step takes one */
+	rem = a >> (FIXEDPT_BITS - 1);
+	a <<= 1;
+	if (rem) {
+		rem = 0;
+		root = 1;
+	}
+#endif
+	for (i = 0; i < (FIXEDPT_BITS + FIXEDPT_FBITS) / 2; i++) {
+		rem = (rem << 2) | (a >> (FIXEDPT_BITS - 2));
+		a <<= 2;
+		root <<= 1;
+		t = (root << 1) | 1;
+		m = -(fixedptu)(rem >= t);
+		rem -= t & m;
+		root |= m & 1;
 	}
-	if (A > FIXEDPT_ONE) {
-		int s = A;
+	/* A * 2^FBITS - root^2 > root: the root is nearer to root + 1 */
+	if (rem > root)
+		root++;
+	return ((fixedpt)root);
+}
+
+
+#if defined(FIXEDPT_TRIG_TABLE) || defined(FIXEDPT_TRIG_CORDIC)
+
+/*
+ * sin, cos and tan work on the angle as a fraction of a full turn, 2^32
+ * being one turn, so that the angle wraps around by itself. The sine and
+ * cosine of the turn are computed in Q30, and rounded once at the end.
+ */
+#define FIXEDPT_TURN_PER_RAD	683565276	/* 2^32 / (2 pi) */
+
+static inline uint32_t
+fixedpt_turn(fixedpt A)
+{
+	return ((uint32_t)(((fixedptd)A * FIXEDPT_TURN_PER_RAD) >> FIXEDPT_FBITS));
+}
+
+#if defined(FIXEDPT_TRIG_TABLE)
 
-		iter = 0;
-		while (s > 0) {
-			s >>= 2;
-			iter++;
+/*
+ * sin(2 pi i / 1024) for a quarter of the turn in Q15, interpolated
+ * linearly: the error of the interpolation is below 5e-6.
+ */
+#define FIXEDPT_SIN_Q15_SIZE	1024
+static const uint16_t fixedpt_sin_q15[FIXEDPT_SIN_Q15_SIZE/4 + 1] = {
+	    0,   201,   402,   603,   804,  1005,  1206,  1407,  1608,  1809,
+	 2009,  2210,  2411,  2611,  2811,  3012,  3212,  3412,  3612,  3812,
+	 4011,  4211,  4410,  4609,  4808,  5007,  5205,  5404,  5602,  5800,
+	 5998,  6195,  6393,  6590,  6787,  6983,  7180,  7376,  7571,  7767,
+	 7962,  8157,  8351,  8546,  8740,  8933,  9127,  9319,  9512,  9704,
+	 9896, 10088, 10279, 10469, 10660, 10850, 11039, 11228, 11417, 11605,
+	11793, 11980, 12167, 12354, 12540, 12725, 12910, 13095, 13279, 13463,
+	13646, 13828, 14010, 14192, 14373, 14553, 14733, 14912, 15091, 15269,
+	15447, 15624, 15800, 15976, 16151, 16326, 16500, 16673, 16846, 17018,
+	17190, 17361, 17531, 17700, 17869, 18037, 18205, 18372, 18538, 18703,
+	18868, 19032, 19195, 19358, 19520, 19681, 19841, 20001, 20160, 20318,
+	20475, 20632, 20788, 20943, 21097, 21251, 21403, 21555, 21706, 21856,
+	22006, 22154, 22302, 22449, 22595, 22740, 22884, 23028, 23170, 23312,
+	23453, 23593, 23732, 23870, 24008, 24144, 24279, 24414, 24548, 24680,
+	24812, 24943, 25073, 25202, 25330, 25457, 25583, 25708, 25833, 25956,
+	26078, 26199, 26320, 26439, 26557, 26674, 26791, 26906, 27020, 27133,
+	27246, 27357, 27467, 27576, 27684, 27791, 27897, 28002, 28106, 28209,
+	28311, 28411, 28511, 28610, 28707, 28803, 28899, 28993, 29086, 29178,
+	29269, 29359, 29448, 29535, 29622, 29707, 29792, 29875, 29957, 30038,
+	30118, 30196, 30274, 30350, 30425, 30499, 30572, 30644, 30715, 30784,
+	30853, 30920, 30986, 31050, 31114, 31177, 31238, 31298, 31357, 31415,
+	31471, 31527, 31581, 31634, 31686, 31737, 31786, 31834, 31881, 31927,
+	31972, 32015, 32058, 32099, 32138, 32177, 32214, 32251, 32286, 32319,
+	32352, 32383, 32413, 32442, 32470, 32496, 32522, 32546, 32568, 32590,
+	32610, 32629, 32647, 32664, 32679, 32693, 32706, 32718, 32729, 32738,
+	32746, 32753, 32758, 32762, 32766, 32767, 32768
+};
+
+static inline int32_t
+fixedpt_sin_q30(uint32_t t)
+{
+	uint32_t pos = t & 0x3fffffff, i, frac;
+	int32_t v;
+
+	/* the second and fourth quarters mirror the first and third */
+	if (t & 0x40000000)
+		pos = 0x40000000 - pos;
+	i = pos >> 22;
+	frac = pos & 0x3fffff;
+	v = (int32_t)fixedpt_sin_q15[i] << 15;
+	if (frac)
+		v += ((int32_t)(fixedpt_sin_q15[i + 1] - fixedpt_sin_q15[i]) *
+		    (int32_t)frac) >> 7;
+	return ((t & 0x80000000) ? -v : v);
+}
+
+static inline void
+fixedpt_sincos_q30(uint32_t t, int32_t *s, int32_t *c)
+{
+	*s = fixedpt_sin_q30(t);
+	*c = fixedpt_sin_q30(t + 0x40000000);
+}
+
+#else /* FIXEDPT_TRIG_CORDIC */
+
+/*
+ * CORDIC in rotation mode: 16 rotations by atan(2^-i), given as fractions
+ * of a turn, leave an error of about 3e-5 at no multiplication at all.
+ */
+#define FIXEDPT_CORDIC_ITER	16
+#define FIXEDPT_CORDIC_K	0x26dd3b6a	/* prod 1/sqrt(1 + 2^-2i) in Q30 */
+static const int32_t fixedpt_cordic_atan[FIXEDPT_CORDIC_ITER] = {
+	0x20000000, 0x12e4051e, 0x09fb385b, 0x051111d4,
+	0x028b0d43, 0x0145d7e1, 0x00a2f61e, 0x00517c55,
+	0x0028be53, 0x00145f2f, 0x000a2f98, 0x000517cc,
+	0x00028be6, 0x000145f3, 0x0000a2fa, 0x0000517d
+};
+
+static inline void
+fixedpt_sincos_q30(uint32_t t, int32_t *s, int32_t *c)
+{
+	int32_t x = FIXEDPT_CORDIC_K, y = 0, z = (int32_t)t, xi;
+	int i, neg = 0;
+
+	/* rotate by half a turn into -1/4 .. 1/4 turn */
+	if ((z > 0x40000000) || (z < -0x40000000)) {
+		z = (int32_t)(t - 0x80000000u);
+		neg = 1;
+	}
+	for (i = 0; i < FIXEDPT_CORDIC_ITER; i++) {
+		xi = x;
+		if (z >= 0) {
+			x -= y >> i;
+			y += xi >> i;
+			z -= fixedpt_cordic_atan[i];
+		} else {
+			x += y >> i;
+			y -= xi >> i;
+			z += fixedpt_cordic_atan[i];
 		}
 	}
+	*s = (neg) ? -y : y;
+	*c = (neg) ? -x : x;
+}
+
+#endif /* FIXEDPT_TRIG_TABLE */
+
+/* Rounds a Q30 number to fixedpt */
+static inline fixedpt
+fixedpt_fromq30(int32_t v)
+{
+#if FIXEDPT_FBITS > 30
+	return ((fixedpt)v << (FIXEDPT_FBITS - 30));
+#elif FIXEDPT_FBITS == 30
+	return (v);
+#else
+	return ((v + ((int32_t)1 << (29 - FIXEDPT_FBITS))) >> (30 - FIXEDPT_FBITS));
+#endif
+}
+
+
+/* Returns the sine of the given fixedpt number. */
+static inline fixedpt
+fixedpt_sin(fixedpt A)
+{
+	int32_t s, c;
+
+	fixedpt_sincos_q30(fixedpt_turn(A), &s, &c);
+	return (fixedpt_fromq30(s));
+}
 
-	/* Newton's iterations */
-	l = (A >> 1) + 1;
-	for (i = 0; i < iter; i++)
-		l = (l + fixedpt_div(A, l)) >> 1;
-	if (invert)
-		return (fixedpt_div(FIXEDPT_ONE, l));
-	return (l);
+
+/* Returns the cosine of the given fixedpt number */
+static inline fixedpt
+fixedpt_cos(fixedpt A)
+{
+	int32_t s, c;
+
+	fixedpt_sincos_q30(fixedpt_turn(A), &s, &c);
+	return (fixedpt_fromq30(c));
 }
 
 
+/* Returns the tangens of the given fixedpt number: the quotient is taken
+ * in fixedpt, which is a 32 bit division for 32 bit fixedpts */
+static inline fixedpt
+fixedpt_tan(fixedpt A)
+{
+	int32_t s, c;
+
+	fixedpt_sincos_q30(fixedpt_turn(A), &s, &c);
+#if FIXEDPT_BITS == 32
+	s >>= FIXEDPT_FBITS + 1;
+	c >>= FIXEDPT_FBITS + 1;
+#endif
+	if (c == 0)
+		return ((s < 0) ? -(fixedpt)((fixedptu)-1 >> 1) : (fixedpt)((fixedptu)-1 >> 1));
+	return (((fixedpt)s << FIXEDPT_FBITS) / c);
+}
+
+#else
+
 /* Returns the sine of the given fixedpt number. 
  * Note: the loss of precision is extraordinary! */
 static inline fixedpt fixedpt_sin(fixedpt fp)
@@ -342,83 +561,140 @@ fixedpt_tan(fixedpt A)
 	return fixedpt_div(fixedpt_sin(A), fixedpt_cos(A));
 }
 
+#endif /* FIXEDPT_TRIG_TABLE || FIXEDPT_TRIG_CORDIC */
+
+
+/*
+ * exp, ln and pow share two Q30 kernels.  fixedpt_log2_q30() normalises
+ * its argument to [1,2), divides by the nearest of 16 points through a
+ * stored reciprocal and finishes with four terms of log2(1+u), |u| < 1/32.
+ * fixedpt_exp2_q30() splits off the integer power of two, looks up
+ * 2^(j/16) and finishes with four terms of 2^g, g < 1/16.  Neither uses a
+ * division or a loop, and both are good to about 2^-26.
+ */
+#define FIXEDPT_Q30_ONE		((int64_t)1 << 30)
+#define FIXEDPT_LOG2E_Q30	1549082005	/* log2(e) */
+#define FIXEDPT_LN2_Q28		186065279	/* ln(2) */
+
+/* 1 / (1 + (2j+1)/32) and -log2 of that, in Q30 */
+static const int32_t fixedpt_log2_inv[16] = {
+	1041204193, 981706811, 928641578, 881018933,
+	838042399, 799063683, 763549742, 731058263,
+	701219150, 673720360, 648296950, 624722516,
+	602802428, 582368447, 563274399, 545392673
+};
+static const int32_t fixedpt_log2_tab[16] = {
+	47667823, 138816582, 224898838, 306448298,
+	383918542, 457698295, 528123240, 595485245,
+	660039670, 722011214, 781598637, 838978603,
+	894308842, 947730758, 999371608, 1049346326
+};
+
+/* 2^(j/16) in Q30 */
+static const int32_t fixedpt_exp2_tab[16] = {
+	1073741824, 1121280436, 1170923762, 1222764986,
+	1276901417, 1333434672, 1392470869, 1454120821,
+	1518500250, 1585730000, 1655936265, 1729250827,
+	1805811301, 1885761398, 1969251188, 2056437387
+};
+
+
+/* Returns log2(A) in Q30 for A > 0 */
+static inline int64_t
+fixedpt_log2_q30(fixedpt A)
+{
+	fixedptu x = A;
+	int64_t m, u, p;
+	int k = 0, j;
+
+#if FIXEDPT_BITS == 64
+	if (x >> 32) {
+		x >>= 32;
+		k += 32;
+	}
+#endif
+	if (x >> 16) {
+		x >>= 16;
+		k += 16;
+	}
+	if (x >> 8) {
+		x >>= 8;
+		k += 8;
+	}
+	if (x >> 4) {
+		x >>= 4;
+		k += 4;
+	}
+	if (x >> 2) {
+		x >>= 2;
+		k += 2;
+	}
+	if (x >> 1)
+		k += 1;
+	/* A / 2^k in Q30, in [1,2) */
+	if (k <= 30)
+		m = (int64_t)A << (30 - k);
+	else
+		m = (int64_t)(A >> (k - 30));
+	j = (m >> 26) & 15;
+	u = ((m * fixedpt_log2_inv[j]) >> 30) - FIXEDPT_Q30_ONE;
+	/* log2(e) * (u - u^2/2 + u^3/3 - u^4/4) */
+	p = -387270501;
+	p = 516360668 + ((u * p) >> 30);
+	p = -774541002 + ((u * p) >> 30);
+	p = FIXEDPT_LOG2E_Q30 + ((u * p) >> 30);
+	p = (u * p) >> 30;
+	return (((int64_t)(k - FIXEDPT_FBITS) << 30) + fixedpt_log2_tab[j] + p);
+}
+
+
+/* Returns 2^Y for Y in Q30, saturated to the fixedpt range */
+static inline fixedpt
+fixedpt_exp2_q30(fixedptd Y)
+{
+	fixedptd k = Y >> 30;
+	int64_t g = (int64_t)(Y & (FIXEDPT_Q30_ONE - 1)), m, p;
+	int j, s;
+
+	if (k >= FIXEDPT_WBITS - 1)
+		return ((fixedpt)((fixedptu)-1 >> 1));
+	if (k < -FIXEDPT_FBITS - 1)
+		return (0);
+	j = g >> 26;
+	g &= ((int64_t)1 << 26) - 1;
+	/* 1 + g ln2 + (g ln2)^2/2 + (g ln2)^3/6 + (g ln2)^4/24 */
+	p = 10327387;
+	p = 59597083 + ((g * p) >> 30);
+	p = 257941248 + ((g * p) >> 30);
+	p = 744261118 + ((g * p) >> 30);
+	p = FIXEDPT_Q30_ONE + ((g * p) >> 30);
+	m = (fixedpt_exp2_tab[j] * p) >> 30;
+	s = 30 - FIXEDPT_FBITS - (int)k;
+	if (s > 0)
+		return ((fixedpt)((m + ((int64_t)1 << (s - 1))) >> s));
+	return ((fixedpt)(m << -s));
+}
+
 
 /* Returns the value exp(x), i.e. e^x of the given fixedpt number. */
 static inline fixedpt
 fixedpt_exp(fixedpt fp)
 {
-	fixedpt xabs, k, z, R, xp;
-	const fixedpt LN2 = fixedpt_rconst(0.69314718055994530942);
-	const fixedpt LN2_INV = fixedpt_rconst(1.4426950408889634074);
-	const fixedpt EXP_P[5] = {
-		fixedpt_rconst(1.66666666666666019037e-01),
-		fixedpt_rconst(-2.77777777770155933842e-03),
-		fixedpt_rconst(6.61375632143793436117e-05),
-		fixedpt_rconst(-1.65339022054652515390e-06),
-		fixedpt_rconst(4.13813679705723846039e-08),
-	};
-
-	if (fp == 0)
-		return (FIXEDPT_ONE);
-	xabs = fixedpt_abs(fp);
-	k = fixedpt_mul(xabs, LN2_INV);
-	k += FIXEDPT_ONE_HALF;
-	k &= ~FIXEDPT_FMASK;
-	if (fp < 0)
-		k = -k;
-	fp -= fixedpt_mul(k, LN2);
-	z = fixedpt_mul(fp, fp);
-	/* Taylor */
-	R = FIXEDPT_TWO +
-	    fixedpt_mul(z, EXP_P[0] + fixedpt_mul(z, EXP_P[1] +
-	    fixedpt_mul(z, EXP_P[2] + fixedpt_mul(z, EXP_P[3] +
-	    fixedpt_mul(z, EXP_P[4])))));
-	xp = FIXEDPT_ONE + fixedpt_div(fixedpt_mul(fp, FIXEDPT_TWO), R - fp);
-	if (k < 0)
-		k = FIXEDPT_ONE >> (-k >> FIXEDPT_FBITS);
-	else
-		k = FIXEDPT_ONE << (k >> FIXEDPT_FBITS);
-	return (fixedpt_mul(k, xp));
+	return (fixedpt_exp2_q30(((fixedptd)fp * FIXEDPT_LOG2E_Q30)
+	    >> FIXEDPT_FBITS));
 }
 
 
 /* Returns the natural logarithm of the given fixedpt number. */
 static inline fixedpt fixedpt_ln(fixedpt x)
 {
-	fixedpt log2, xi;
-	fixedpt f, s, z, w, R;
-	const fixedpt LN2 = fixedpt_rconst(0.69314718055994530942);
-	const fixedpt LG[7] = {
-		fixedpt_rconst(6.666666666666735130e-01),
-		fixedpt_rconst(3.999999999940941908e-01),
-		fixedpt_rconst(2.857142874366239149e-01),
-		fixedpt_rconst(2.222219843214978396e-01),
-		fixedpt_rconst(1.818357216161805012e-01),
-		fixedpt_rconst(1.531383769920937332e-01),
-		fixedpt_rconst(1.479819860511658591e-01)
-	};
-
 	if (x < 0)
 		return (0);
 	if (x == 0)
 		return 0xffffffff;
 
-	log2 = 0;
-	xi = x;
-	while (xi > FIXEDPT_TWO) {
-		xi >>= 1;
-		log2++;
-	}
-	f = xi - FIXEDPT_ONE;
-	s = fixedpt_div(f, FIXEDPT_TWO + f);
-	z = fixedpt_mul(s, s);
-	w = fixedpt_mul(z, z);
-	R = fixedpt_mul(w, LG[1] + fixedpt_mul(w, LG[3]
-	    + fixedpt_mul(w, LG[5]))) + fixedpt_mul(z, LG[0]
-	    + fixedpt_mul(w, LG[2] + fixedpt_mul(w, LG[4]
-	    + fixedpt_mul(w, LG[6]))));
-	return (fixedpt_mul(LN2, (log2 << FIXEDPT_FBITS)) + f
-	    - fixedpt_mul(s, f - R));
+	return ((fixedpt)(((fixedptd)fixedpt_log2_q30(x) * FIXEDPT_LN2_Q28
+	    + ((fixedptd)1 << (57 - FIXEDPT_FBITS))) >> (58 - FIXEDPT_FBITS)));
 }
 	
 
@@ -429,16 +705,57 @@ static inline fixedpt fixedpt_log(fixedpt x, fixedpt base)
 }
 
 
-/* Return the power value (n^exp) of the given fixedpt numbers */
+/*
+ * Returns A^n for a non-negative integer n by repeated squaring, rounding
+ * each product and saturating to the fixedpt range.
+ */
+static inline fixedpt
+fixedpt_powi(fixedpt A, fixedptu n)
+{
+	const fixedptd max = (fixedptu)-1 >> 1;
+	fixedptd r = FIXEDPT_ONE, b = A;
+
+	while (n) {
+		if (n & 1) {
+			r = (r * b + FIXEDPT_ONE_HALF) >> FIXEDPT_FBITS;
+			if (r > max)
+				r = max;
+			else if (r < -max)
+				r = -max;
+		}
+		n >>= 1;
+		if (n) {
+			b = (b * b + FIXEDPT_ONE_HALF) >> FIXEDPT_FBITS;
+			if (b > max)
+				b = max;
+		}
+	}
+	return ((fixedpt)r);
+}
+
+
+/*
+ * Return the power value (n^exp) of the given fixedpt numbers.  Whole
+ * non-negative exponents multiply by squaring, which also allows negative
+ * bases; everything else goes through 2^(exp * log2(n)).
+ */
 static inline fixedpt fixedpt_pow(fixedpt n, fixedpt exp)
 {
-  if (exp == 0)
-    return (FIXEDPT_ONE);
+	fixedptd l, y;
+	fixedpt e = exp >> FIXEDPT_FBITS, r;
+
+	if ((exp & FIXEDPT_FMASK) == 0 && exp >= 0)
+		return (fixedpt_powi(n, e));
 
-  if (n < 0)
-    return 0;
+	if (n == 0)
+		return (exp < 0 ? (fixedpt)((fixedptu)-1 >> 1) : 0);
+	if (n < 0 && (exp & FIXEDPT_FMASK))
+		return 0;
 
-  return (fixedpt_exp(fixedpt_mul(fixedpt_ln(n), exp)));
+	l = fixedpt_log2_q30(fixedpt_abs(n));
+	y = l * e + ((l * (exp & FIXEDPT_FMASK)) >> FIXEDPT_FBITS);
+	r = fixedpt_exp2_q30(y);
+	return ((n < 0 && (e & 1)) ? -r : r);
 }
 
 #endif
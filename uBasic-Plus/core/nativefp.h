@@ -0,0 +1,152 @@
+/*-
+ * Copyright (c) 2017-18, Marijan Kostrun <mkostrun@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Native floats for VARIABLE_TYPE_FLOAT_NATIVE:
+ *    the part of the fixedptc.h interface that the interpreter uses, for
+ *    VARIABLE_TYPE float (VARIABLE_STORAGE_INT32) or double
+ *    (VARIABLE_STORAGE_INT64). Arithmetic is done by the FPU, the math
+ *    functions are those of libm, which the compiler replaces by FPU
+ *    instructions where it can (sqrtf on Cortex-M4F).
+ */
+
+#ifndef __NATIVEFP_H__
+#define __NATIVEFP_H__
+
+#include <math.h>
+#include <float.h>
+
+#if defined(VARIABLE_STORAGE_INT64)
+#define NATIVEFP(fn)        fn
+#define NATIVEFP_INT        int64_t
+#define NATIVEFP_UINT       uint64_t
+#define NATIVEFP_INT_MIN    INT64_MIN
+#define NATIVEFP_INT_MAX    INT64_MAX
+#define NATIVEFP_DECIMALS   10
+#define NATIVEFP_DIGITS     17
+#else
+#define NATIVEFP(fn)        fn##f
+#define NATIVEFP_INT        int32_t
+#define NATIVEFP_UINT       uint32_t
+#define NATIVEFP_INT_MIN    INT32_MIN
+#define NATIVEFP_INT_MAX    INT32_MAX
+#define NATIVEFP_DECIMALS   4
+#define NATIVEFP_DIGITS     9
+#endif
+/* NATIVEFP_DECIMALS are printed, up to NATIVEFP_DIGITS decimals are read
+   from numbers in the script and from input */
+
+/* whole numbers with up to this many bits are exact: ran and uniform */
+#if defined(VARIABLE_STORAGE_INT64)
+#define FIXEDPT_WBITS       32
+#else
+#define FIXEDPT_WBITS       24
+#endif
+
+/* raw values are those of the matching fixed point build, 32.32 for double
+   and 24.8 for float: hex and binary numbers in the script, print hex and
+   dec, &, | and not, and the digital channel numbers use them, so that
+   scripts give the same results in either build */
+#if defined(VARIABLE_STORAGE_INT64)
+#define NATIVEFP_FBITS      32
+#else
+#define NATIVEFP_FBITS      8
+#endif
+#define NATIVEFP_RAW_ONE    ((VARIABLE_TYPE) ((uint64_t) 1 << NATIVEFP_FBITS))
+
+#define NATIVEFP_2PI        6.28318530717958647692
+
+#define FIXEDPT_ONE         ((VARIABLE_TYPE) 1)
+#define FIXEDPT_ONE_HALF    ((VARIABLE_TYPE) 0.5)
+#define FIXEDPT_TWO_PI      ((VARIABLE_TYPE) NATIVEFP_2PI)
+
+#define fixedpt_rconst(R)   ((VARIABLE_TYPE) (R))
+
+#define fixedpt_fromint(I)  ((VARIABLE_TYPE) (I))
+#define fixedpt_toint(F)    nativefp_toint(F)
+#define fixedpt_xmul(A,B)   ((A) * (B))
+#define fixedpt_xdiv(A,B)   ((A) / (B))
+#define fixedpt_sqrt(A)     NATIVEFP(sqrt)(A)
+#define fixedpt_sin(A)      NATIVEFP(sin)(A)
+#define fixedpt_cos(A)      NATIVEFP(cos)(A)
+#define fixedpt_tan(A)      NATIVEFP(tan)(A)
+#define fixedpt_exp(A)      NATIVEFP(exp)(A)
+#define fixedpt_ln(A)       NATIVEFP(log)(A)
+#define fixedpt_pow(A,B)    NATIVEFP(pow)((A), (B))
+
+/* the whole part, rounded down as the arithmetic shift of fixedpt_toint()
+   does, and saturated where the conversion would be undefined */
+static inline NATIVEFP_INT nativefp_toint(VARIABLE_TYPE a)
+{
+  a = NATIVEFP(floor)(a);
+  if (a >= -(VARIABLE_TYPE) NATIVEFP_INT_MIN)
+    return NATIVEFP_INT_MAX;
+  if ( !(a >= (VARIABLE_TYPE) NATIVEFP_INT_MIN) )
+    return NATIVEFP_INT_MIN;
+  return (NATIVEFP_INT) a;
+}
+
+static inline VARIABLE_TYPE nativefp_fromraw(NATIVEFP_INT i)
+{
+  return (VARIABLE_TYPE) i / NATIVEFP_RAW_ONE;
+}
+
+/* rounded down, as fixedpt_toint() */
+static inline NATIVEFP_INT nativefp_toraw(VARIABLE_TYPE a)
+{
+  return nativefp_toint(a * NATIVEFP_RAW_ONE);
+}
+
+/* same text as str_fixedpt() accepts: sign, digits, and up to
+   decimal_places digits past the decimal point */
+static inline VARIABLE_TYPE str_fixedpt(char * p, uint16_t plen, uint8_t decimal_places)
+{
+  VARIABLE_TYPE r = 0, scale = 1;
+  uint16_t i = 0;
+  uint8_t i_minus = 0;
+
+  while ( (i < plen) && isspace((uint8_t) p[i]) )
+    i++;
+  if ( (i < plen) && ((p[i] == '-') || (p[i] == '+')) )
+    i_minus = (p[i++] == '-');
+
+  for ( ; (i < plen) && isdigit((uint8_t) p[i]); i++)
+    r = 10 * r + (p[i] - '0');
+
+  if ( (i < plen) && (p[i] == '.') )
+  {
+    for (i++; (i < plen) && isdigit((uint8_t) p[i]) && decimal_places; i++, decimal_places--)
+    {
+      r = 10 * r + (p[i] - '0');
+      scale *= 10;
+    }
+    r /= scale;
+  }
+
+  return (i_minus) ? -r : r;
+}
+
+#endif /* __NATIVEFP_H__ */
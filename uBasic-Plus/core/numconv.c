@@ -0,0 +1,235 @@
+/*-
+ * Copyright (c) 2017-18, Marijan Kostrun <mkostrun@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+#include "numconv.h"
+
+static const char hex_digits[] = "0123456789abcdef";
+
+/*---------------------------------------------------------------------------*/
+// quotient and remainder of division by 10 using shifts and adds only
+// (Hacker's Delight, divu10)
+static inline NUMCONV_UINT numconv_divu10(NUMCONV_UINT n, uint8_t *rem)
+{
+  NUMCONV_UINT q, r;
+  q = (n >> 1) + (n >> 2);
+  q = q + (q >> 4);
+  q = q + (q >> 8);
+  q = q + (q >> 16);
+#if defined(VARIABLE_STORAGE_INT64)
+  q = q + (q >> 32);
+#endif
+  q = q >> 3;
+  r = n - (((q << 2) + q) << 1);
+  if (r > 9)
+  {
+    q++;
+    r -= 10;
+  }
+  *rem = r;
+  return q;
+}
+
+/*---------------------------------------------------------------------------*/
+// unsigned decimal: digits are generated from the right
+static uint8_t numconv_udec(char *dest, NUMCONV_UINT value)
+{
+  char tmp[20];
+  uint8_t i=0, n=0, d;
+
+  do
+  {
+    value = numconv_divu10(value, &d);
+    tmp[i++] = '0' + d;
+  }
+  while (value);
+
+  while (i)
+    dest[n++] = tmp[--i];
+
+  dest[n] = '\0';
+  return n;
+}
+
+/*---------------------------------------------------------------------------*/
+uint8_t numconv_dec(char *dest, NUMCONV_INT value)
+{
+  if (value < 0)
+  {
+    *dest = '-';
+    return 1 + numconv_udec(dest+1, -((NUMCONV_UINT) value));
+  }
+  return numconv_udec(dest, value);
+}
+
+/*---------------------------------------------------------------------------*/
+uint8_t numconv_hex(char *dest, NUMCONV_UINT value)
+{
+  uint8_t n=0;
+  int8_t  shift=8*sizeof(NUMCONV_UINT)-4;
+
+  // skip leading zeros
+  while ( (shift > 0) && !((value >> shift) & 0x0f) )
+    shift -= 4;
+
+  for (; shift>=0; shift-=4)
+    dest[n++] = hex_digits[(value >> shift) & 0x0f];
+
+  dest[n] = '\0';
+  return n;
+}
+
+#if defined(FIXEDPT_FBITS)
+/*---------------------------------------------------------------------------*/
+// same text as fixedpt_str(): up to max_dec decimals (at least one) are
+// truncated, not rounded, and a single trailing zero is cut off together
+// with a decimal point that would end the text
+uint8_t numconv_fixedpt(char *dest, fixedpt value, uint8_t max_dec)
+{
+  uint8_t  n=0, ndec=0;
+  NUMCONV_UINT m, fr;
+
+  m = value;
+  if (value < 0)
+  {
+    dest[n++] = '-';
+    m = -m;
+  }
+
+  n += numconv_udec(dest+n, m >> FIXEDPT_FBITS);
+  dest[n++] = '.';
+
+  fr = m & FIXEDPT_FMASK;
+  do
+  {
+    fr = (fr << 3) + (fr << 1);
+    dest[n++] = '0' + (fr >> FIXEDPT_FBITS);
+    fr &= FIXEDPT_FMASK;
+    ndec++;
+  }
+  while (fr != 0 && ndec < max_dec);
+
+  if (dest[n-1] == '0')
+  {
+    n--;
+    if (dest[n-1] == '.')
+      n--;
+  }
+  dest[n] = '\0';
+  return n;
+}
+#endif
+
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+/*---------------------------------------------------------------------------*/
+// whole part and max_dec decimals, rounded to nearest, with trailing zeros
+// and a decimal point that would end the text cut off; numbers too large
+// for NUMCONV_UINT, or too small to show a decimal, are printed as
+// d.dddde+XX
+#if defined(VARIABLE_STORAGE_INT64)
+#define NUMCONV_FLOAT_EXP   1e15
+#else
+#define NUMCONV_FLOAT_EXP   1e9f
+#endif
+uint8_t numconv_float(char *dest, VARIABLE_TYPE value, uint8_t max_dec)
+{
+  uint8_t  n=0, i, d;
+  int16_t  e=0;
+  NUMCONV_UINT ip, fr, scale=1;
+
+  if (value != value)
+  {
+    strcpy(dest, "nan");
+    return 3;
+  }
+
+  if (value < 0)
+  {
+    dest[n++] = '-';
+    value = -value;
+  }
+
+  if (value > VARIABLE_TYPE_MAX)
+  {
+    strcpy(dest+n, "inf");
+    return n+3;
+  }
+
+  for (i=0; i<max_dec; i++)
+    scale = (scale << 3) + (scale << 1);
+
+  if ( (value >= NUMCONV_FLOAT_EXP) || ((value > 0) && (value * scale < 1)) )
+  {
+    while (value >= 10)
+    {
+      value /= 10;
+      e++;
+    }
+    while (value < 1)
+    {
+      value *= 10;
+      e--;
+    }
+  }
+
+  ip = (NUMCONV_UINT) value;
+  fr = (NUMCONV_UINT) ((value - (VARIABLE_TYPE) ip) * (VARIABLE_TYPE) scale + (VARIABLE_TYPE) 0.5);
+  if (fr >= scale)
+  {
+    ip++;
+    fr -= scale;
+  }
+  if (e && ip > 9)
+  {
+    ip = 1;
+    e++;
+  }
+
+  n += numconv_udec(dest+n, ip);
+
+  if (fr)
+  {
+    dest[n++] = '.';
+    for (i=max_dec; i; i--)
+    {
+      fr = numconv_divu10(fr, &d);
+      dest[n+i-1] = '0' + d;
+    }
+    n += max_dec;
+    while (dest[n-1] == '0')
+      n--;
+  }
+
+  if (e)
+  {
+    dest[n++] = 'e';
+    dest[n++] = (e < 0) ? '-' : '+';
+    n += numconv_udec(dest+n, (e < 0) ? -e : e);
+  }
+
+  dest[n] = '\0';
+  return n;
+}
+#endif
@@ -0,0 +1,71 @@
+/*-
+ * Copyright (c) 2017-18, Marijan Kostrun <mkostrun@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Number to text conversion without sprintf:
+ *    Cortex M0 has no hardware divide, and sprintf from newlib-nano is
+ *    both large and slow. Decimal digits are extracted here by division by
+ *    ten done with shifts and adds, hexadecimal digits by shifting, and the
+ *    fraction of fixed point numbers by multiplying by ten in 32 bits (64 bits
+ *    with VARIABLE_STORAGE_INT64). Native floats are split into whole part
+ *    and rounded decimals that are then printed as integers.
+ * All functions write '\0'-terminated text to 'dest' and return its length.
+ */
+
+#ifndef __NUMCONV_H__
+#define __NUMCONV_H__
+
+#include "config.h"
+
+/* numbers are converted at the width of VARIABLE_TYPE; the longest text
+   produced: sign, 10 (20) digits, decimal point, decimals and '\0'
+   (sign, 15 digits, decimal point, 10 decimals and '\0' for doubles) */
+#if defined(VARIABLE_STORAGE_INT64)
+#define NUMCONV_INT     int64_t
+#define NUMCONV_UINT    uint64_t
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+#define NUMCONV_MAXLEN  32
+#else
+#define NUMCONV_MAXLEN  24
+#endif
+#else
+#define NUMCONV_INT     int32_t
+#define NUMCONV_UINT    uint32_t
+#define NUMCONV_MAXLEN  16
+#endif
+
+uint8_t numconv_dec(char *dest, NUMCONV_INT value);
+uint8_t numconv_hex(char *dest, NUMCONV_UINT value);
+
+#if defined(FIXEDPT_FBITS)
+uint8_t numconv_fixedpt(char *dest, fixedpt value, uint8_t max_dec);
+#endif
+
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+uint8_t numconv_float(char *dest, VARIABLE_TYPE value, uint8_t max_dec);
+#endif
+
+#endif /* __NUMCONV_H__ */
@@ -36,6 +36,7 @@
 
 #include "config.h"
 #include "tokenizer.h"
+#include "numconv.h"
 extern volatile _Status ubasic_status;
 // uint16_t    current_line=0;
 
@@ -60,12 +61,17 @@ static const struct keyword_token keywords[] =
   {"left$",                   TOKENIZER_LEFT$},
   {"right$",                  TOKENIZER_RIGHT$},
   {"mid$",                    TOKENIZER_MID$},
+  {"field$",                  TOKENIZER_FIELD$},
   {"str$",                    TOKENIZER_STR$},
   {"chr$",                    TOKENIZER_CHR$},
   {"val",                     TOKENIZER_VAL},
   {"len",                     TOKENIZER_LEN},
   {"instr",                   TOKENIZER_INSTR},
   {"asc",                     TOKENIZER_ASC},
+#if defined(VARIABLE_TYPE_ARRAY) || defined(VARIABLE_TYPE_STRING_ARRAY)
+  {"split ",                  TOKENIZER_SPLIT},
+  {"into ",                   TOKENIZER_INTO},
+#endif
 #endif
 // end of string additions
   {"let ", TOKENIZER_LET},
@@ -91,12 +97,54 @@ static const struct keyword_token keywords[] =
   {"gosub ", TOKENIZER_GOSUB},
   {"return", TOKENIZER_RETURN},
   {"end", TOKENIZER_END},
+#if defined(UBASIC_SCRIPT_HAVE_BIT_OPERATIONS)
+  // before "pop"
+  {"shl", TOKENIZER_SHL},
+  {"shr", TOKENIZER_SHR},
+  {"bit", TOKENIZER_BIT},
+  {"setbit", TOKENIZER_SETBIT},
+  {"clrbit", TOKENIZER_CLRBIT},
+  {"popcount", TOKENIZER_POPCOUNT},
+  {"clz", TOKENIZER_CLZ},
+#endif
 #if defined(UBASIC_SCRIPT_HAVE_SLEEP)
   {"sleep", TOKENIZER_SLEEP},
 #endif
-#if defined(VARIABLE_TYPE_ARRAY)
+#if defined(VARIABLE_TYPE_ARRAY) || defined(VARIABLE_TYPE_STRING_ARRAY)
   {"dim ", TOKENIZER_DIM},
 #endif
+#if defined(VARIABLE_TYPE_ARRAY)
+  {"as ", TOKENIZER_AS},
+  {"asum", TOKENIZER_ASUM},
+  {"amin", TOKENIZER_AMIN},
+  {"amax", TOKENIZER_AMAX},
+  {"amean", TOKENIZER_AMEAN},
+  {"amedian", TOKENIZER_AMEDIAN},
+  {"afind", TOKENIZER_AFIND},
+  {"adot", TOKENIZER_ADOT},
+  {"afill", TOKENIZER_AFILL},
+  {"acopy", TOKENIZER_ACOPY},
+  {"ashift", TOKENIZER_ASHIFT},
+  {"arotate", TOKENIZER_AROTATE},
+  {"asort", TOKENIZER_ASORT},
+  {"ring", TOKENIZER_RING},
+  {"push ", TOKENIZER_PUSH},
+  {"pop", TOKENIZER_POP},
+  {"filter_init ", TOKENIZER_FILTER_INIT},
+  {"filter", TOKENIZER_FILTER},
+  {"matmul ", TOKENIZER_MATMUL},
+  {"mattrans ", TOKENIZER_MATTRANS},
+  {"matvec ", TOKENIZER_MATVEC},
+  {"interp", TOKENIZER_INTERP},
+  {"polyval", TOKENIZER_POLYVAL},
+#if defined(UBASIC_SCRIPT_HAVE_RANDOM_NUMBER_GENERATOR)
+  {"arand", TOKENIZER_ARAND},
+#endif
+#if defined(UBASIC_SCRIPT_HAVE_FFT)
+  {"fft ", TOKENIZER_FFT},
+  {"amag ", TOKENIZER_AMAG},
+#endif
+#endif
 #if defined(UBASIC_SCRIPT_HAVE_TICTOC)
   {"tic", TOKENIZER_TIC},
 #endif
@@ -106,7 +154,7 @@ static const struct keyword_token keywords[] =
 #if defined(UBASIC_SCRIPT_HAVE_RANDOM_NUMBER_GENERATOR)
   {"ran", TOKENIZER_RAN},
 #endif
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+#if defined(UBASIC_HAVE_FLOATS)
   {"sqrt", TOKENIZER_SQRT},
   {"sin",  TOKENIZER_SIN},
   {"cos", TOKENIZER_COS},
@@ -115,6 +163,7 @@ static const struct keyword_token keywords[] =
   {"ln", TOKENIZER_LN},
   #if defined(UBASIC_SCRIPT_HAVE_RANDOM_NUMBER_GENERATOR)
   {"uniform", TOKENIZER_UNIFORM},
+  {"gauss", TOKENIZER_GAUSS},
   #endif
   {"abs", TOKENIZER_ABS},
   {"floor", TOKENIZER_FLOOR},
@@ -328,7 +377,7 @@ static uint8_t get_next_token(void)
       if (*nextptr=='d' || *nextptr=='D' || *nextptr=='l' || *nextptr=='L')
         return TOKENIZER_INT;
 
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+  #if defined(UBASIC_HAVE_FLOATS)
       if (i_dot)
         return TOKENIZER_FLOAT;
   #endif
@@ -525,10 +574,21 @@ VARIABLE_TYPE tokenizer_num(void)
 }
 
 
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+// the bits wrap as in the fixed point build, whose raw value this is
+#define TOKENIZER_RAW(u)    nativefp_fromraw((NATIVEFP_INT) (u))
+#else
+#define TOKENIZER_RAW(u)    (u)
+#endif
+
 VARIABLE_TYPE tokenizer_int(void)
 {
   uint8_t *c = (uint8_t *) ptr;
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+  NATIVEFP_UINT rval=0;
+#else
   VARIABLE_TYPE rval=0;
+#endif
   if ( (*c=='0') && (*(c+1)=='x' || *(c+1)=='X') )
   {
     c+= 2;
@@ -536,28 +596,28 @@ VARIABLE_TYPE tokenizer_int(void)
     {
       if (*c>='0' && *c<='9')
       {
-        rval <<= 4;
+        rval *= 16;
         rval += (*c - '0');
         c++;
         continue;
       }
       if ((*c>='a') && (*c<='f'))
       {
-        rval <<= 4;
+        rval *= 16;
         rval += (*c - 87); // 87 = 'a' - 10
         c++;
         continue;
       }
       if ((*c>='A') && (*c<='F'))
       {
-        rval <<= 4;
+        rval *= 16;
         rval += (*c - 55);// 55 = 'A' - 10
         c++;
         continue;
       }
       break;
     }
-    return rval;
+    return TOKENIZER_RAW(rval);
   }
   if ( (*c=='0') && (*(c+1)=='b' || *(c+1)=='B') )
   {
@@ -566,37 +626,51 @@ VARIABLE_TYPE tokenizer_int(void)
     {
       if (*c=='0' || *c=='1')
       {
-        rval <<= 1;
+        rval *= 2;
         rval += (*c - '0');
         c++;
         continue;
       }
       break;
     }
-    return rval;
+    return TOKENIZER_RAW(rval);
   }
 
-  return tokenizer_num();
+  return TOKENIZER_RAW(tokenizer_num());
 }
 
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+#if defined(UBASIC_HAVE_FLOATS)
 /*---------------------------------------------------------------------------*/
 VARIABLE_TYPE tokenizer_float(void)
 {
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+  return str_fixedpt((char*)ptr, nextptr-ptr, NATIVEFP_DIGITS);
+#else
   return str_fixedpt((char*)ptr, nextptr-ptr, FIXEDPT_FBITS>>1);
+#endif
 }
 #endif
 
 #if defined(VARIABLE_TYPE_STRING)
 /*---------------------------------------------------------------------------*/
-void tokenizer_string(char *dest, uint8_t len)
+// length of the string literal between its quotes
+uint16_t tokenizer_stringlen(void)
+{
+  if(tokenizer_token() != TOKENIZER_STRING)
+  {
+    return 0;
+  }
+  return (nextptr - ptr - 2);
+}
+/*---------------------------------------------------------------------------*/
+uint16_t tokenizer_string(char *dest, uint16_t len)
 {
   char *string_end, quote_char;
-  uint8_t string_len;
+  uint16_t string_len;
 
   if(tokenizer_token() != TOKENIZER_STRING)
   {
-    return;
+    return 0;
   }
   quote_char = *ptr;
 
@@ -611,7 +685,7 @@ void tokenizer_string(char *dest, uint8_t len)
     string_end = strchr(string_end, quote_char);
     if(string_end == NULL)
     {
-      return;
+      return 0;
     }
   }
   while ( *(string_end - 1) == '\\');
@@ -623,7 +697,7 @@ void tokenizer_string(char *dest, uint8_t len)
   }
   memcpy(dest, ptr + 1, string_len);
   dest[string_len] = 0;
-  return;
+  return string_len;
 }
 #endif
 
@@ -646,6 +720,8 @@ void tokenizer_label(char *dest, uint8_t len)
       continue;
     break;
   }
+  if (string_len >= len)
+    string_len = len - 1;
   memcpy(dest, ptr, string_len);
   dest[string_len] = 0;
 }
@@ -660,9 +736,10 @@ void tokenizer_error_print(VARIABLE_TYPE token)
 //     sprintf(msg,"%d:", current_line);
 //     print_serial(msg);
 //   }
-  print_serial("Err");
-  sprintf(msg,"[%u]:", (uint8_t) token);
+  print_serial("Err[");
+  numconv_dec(msg, (uint8_t) token);
   print_serial(msg);
+  print_serial("]:");
   print_serial((char*)ptr-1);
   print_serial("\n");
 }
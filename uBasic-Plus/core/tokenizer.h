@@ -57,115 +57,162 @@ enum {
 /*7*/  TOKENIZER_LEFT$,
 /*8*/  TOKENIZER_RIGHT$,
 /*9*/  TOKENIZER_MID$,
-/*10*/  TOKENIZER_STR$,
-/*11*/  TOKENIZER_CHR$,
-/*12*/  TOKENIZER_VAL,
-/*13*/  TOKENIZER_LEN,
-/*14*/  TOKENIZER_INSTR,
-/*15*/  TOKENIZER_ASC,
+/*10*/  TOKENIZER_FIELD$,
+/*11*/  TOKENIZER_STR$,
+/*12*/  TOKENIZER_CHR$,
+/*13*/  TOKENIZER_VAL,
+/*14*/  TOKENIZER_LEN,
+/*15*/  TOKENIZER_INSTR,
+/*16*/  TOKENIZER_ASC,
+#if defined(VARIABLE_TYPE_ARRAY) || defined(VARIABLE_TYPE_STRING_ARRAY)
+/*17*/  TOKENIZER_SPLIT,
+/*18*/  TOKENIZER_INTO,
+#endif
 #endif
 // end of string additions
-/*16*/  TOKENIZER_LET,
-/*17*/  TOKENIZER_PRINTLN,
-/*18*/  TOKENIZER_PRINT,
-/*19*/  TOKENIZER_IF,
-/*20*/  TOKENIZER_THEN,
-/*21*/  TOKENIZER_ELSE,
-/*22*/  TOKENIZER_ENDIF,
-/*23*/  TOKENIZER_FOR,
-/*24*/  TOKENIZER_TO,
-/*25*/  TOKENIZER_NEXT,
-/*26*/  TOKENIZER_STEP,
-/*27*/  TOKENIZER_WHILE,
-/*28*/  TOKENIZER_ENDWHILE,
-/*29*/  TOKENIZER_GOTO,
-/*30*/  TOKENIZER_GOSUB,
-/*31*/  TOKENIZER_RETURN,
-/*32*/  TOKENIZER_END,
-/*33*/  TOKENIZER_COMMA,
-/*34*/  TOKENIZER_PLUS,
-/*35*/  TOKENIZER_MINUS,
-/*36*/  TOKENIZER_AND,
-/*37*/  TOKENIZER_OR,
-/*38*/  TOKENIZER_ASTR,
-/*39*/  TOKENIZER_SLASH,
-/*40*/  TOKENIZER_MOD,
-/*41*/  TOKENIZER_LEFTPAREN,
-/*42*/  TOKENIZER_RIGHTPAREN,
-/*43*/  TOKENIZER_LT,
-/*44*/  TOKENIZER_GT,
-/*45*/  TOKENIZER_EQ,
-/*46*/  TOKENIZER_EOL,
+/*19*/  TOKENIZER_LET,
+/*20*/  TOKENIZER_PRINTLN,
+/*21*/  TOKENIZER_PRINT,
+/*22*/  TOKENIZER_IF,
+/*23*/  TOKENIZER_THEN,
+/*24*/  TOKENIZER_ELSE,
+/*25*/  TOKENIZER_ENDIF,
+/*26*/  TOKENIZER_FOR,
+/*27*/  TOKENIZER_TO,
+/*28*/  TOKENIZER_NEXT,
+/*29*/  TOKENIZER_STEP,
+/*30*/  TOKENIZER_WHILE,
+/*31*/  TOKENIZER_ENDWHILE,
+/*32*/  TOKENIZER_GOTO,
+/*33*/  TOKENIZER_GOSUB,
+/*34*/  TOKENIZER_RETURN,
+/*35*/  TOKENIZER_END,
+/*36*/  TOKENIZER_COMMA,
+/*37*/  TOKENIZER_PLUS,
+/*38*/  TOKENIZER_MINUS,
+/*39*/  TOKENIZER_AND,
+/*40*/  TOKENIZER_OR,
+/*41*/  TOKENIZER_ASTR,
+/*42*/  TOKENIZER_SLASH,
+/*43*/  TOKENIZER_MOD,
+/*44*/  TOKENIZER_LEFTPAREN,
+/*45*/  TOKENIZER_RIGHTPAREN,
+/*46*/  TOKENIZER_LT,
+/*47*/  TOKENIZER_GT,
+/*48*/  TOKENIZER_EQ,
+/*49*/  TOKENIZER_EOL,
 //
 // Plus : Start
 //
-/*47*/  TOKENIZER_NE,
-/*48*/  TOKENIZER_GE,
-/*49*/  TOKENIZER_LE,
-/*50*/  TOKENIZER_LAND,
-/*51*/  TOKENIZER_LOR,
-/*52*/  TOKENIZER_LNOT,
-/*53*/  TOKENIZER_NOT,
-/*54*/  TOKENIZER_PRINT_HEX,
-/*55*/  TOKENIZER_PRINT_DEC,
+/*50*/  TOKENIZER_NE,
+/*51*/  TOKENIZER_GE,
+/*52*/  TOKENIZER_LE,
+/*53*/  TOKENIZER_LAND,
+/*54*/  TOKENIZER_LOR,
+/*55*/  TOKENIZER_LNOT,
+/*56*/  TOKENIZER_NOT,
+/*57*/  TOKENIZER_PRINT_HEX,
+/*58*/  TOKENIZER_PRINT_DEC,
+#if defined(UBASIC_SCRIPT_HAVE_BIT_OPERATIONS)
+/*59*/  TOKENIZER_SHL,
+/*60*/  TOKENIZER_SHR,
+/*61*/  TOKENIZER_BIT,
+/*62*/  TOKENIZER_SETBIT,
+/*63*/  TOKENIZER_CLRBIT,
+/*64*/  TOKENIZER_POPCOUNT,
+/*65*/  TOKENIZER_CLZ,
+#endif
 #if defined(UBASIC_SCRIPT_HAVE_INPUT_FROM_SERIAL)
-/*56*/  TOKENIZER_INPUT,
+/*66*/  TOKENIZER_INPUT,
 #endif
 #if defined(UBASIC_SCRIPT_HAVE_SLEEP)
-/*57*/  TOKENIZER_SLEEP,
+/*67*/  TOKENIZER_SLEEP,
 #endif
 #if defined(UBASIC_SCRIPT_HAVE_GPIO_CHANNELS)
-/*58*/  TOKENIZER_PINMODE,
-/*59*/  TOKENIZER_DREAD,
-/*60*/  TOKENIZER_DWRITE,
+/*68*/  TOKENIZER_PINMODE,
+/*69*/  TOKENIZER_DREAD,
+/*70*/  TOKENIZER_DWRITE,
+#endif
+#if defined(VARIABLE_TYPE_ARRAY) || defined(VARIABLE_TYPE_STRING_ARRAY)
+/*71*/  TOKENIZER_DIM,
 #endif
 #if defined(VARIABLE_TYPE_ARRAY)
-/*61*/  TOKENIZER_DIM,
-/*62*/  TOKENIZER_ARRAYVARIABLE,
+/*72*/  TOKENIZER_ARRAYVARIABLE,
+/*73*/  TOKENIZER_AS,
+/*74*/  TOKENIZER_ASUM,
+/*75*/  TOKENIZER_AMIN,
+/*76*/  TOKENIZER_AMAX,
+/*77*/  TOKENIZER_AMEAN,
+/*78*/  TOKENIZER_AMEDIAN,
+/*79*/  TOKENIZER_AFIND,
+/*80*/  TOKENIZER_ADOT,
+/*81*/  TOKENIZER_AFILL,
+/*82*/  TOKENIZER_ACOPY,
+/*83*/  TOKENIZER_ASHIFT,
+/*84*/  TOKENIZER_AROTATE,
+/*85*/  TOKENIZER_ASORT,
+/*86*/  TOKENIZER_RING,
+/*87*/  TOKENIZER_PUSH,
+/*88*/  TOKENIZER_POP,
+/*89*/  TOKENIZER_FILTER_INIT,
+/*90*/  TOKENIZER_FILTER,
+/*91*/  TOKENIZER_MATMUL,
+/*92*/  TOKENIZER_MATTRANS,
+/*93*/  TOKENIZER_MATVEC,
+/*94*/  TOKENIZER_INTERP,
+/*95*/  TOKENIZER_POLYVAL,
+#if defined(UBASIC_SCRIPT_HAVE_RANDOM_NUMBER_GENERATOR)
+/*96*/  TOKENIZER_ARAND,
+#endif
+#if defined(UBASIC_SCRIPT_HAVE_FFT)
+/*97*/  TOKENIZER_FFT,
+/*98*/  TOKENIZER_AMAG,
+#endif
 #endif
 #if defined(UBASIC_SCRIPT_HAVE_RANDOM_NUMBER_GENERATOR)
-/*63*/  TOKENIZER_RAN,
+/*99*/  TOKENIZER_RAN,
+#endif
 #if defined(UBASIC_SCRIPT_HAVE_TICTOC)
-/*64*/  TOKENIZER_TIC,
-/*65*/  TOKENIZER_TOC,
-#endif
-#endif
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
-/*66*/  TOKENIZER_INT,
-/*67*/  TOKENIZER_FLOAT,
-/*68*/  TOKENIZER_SQRT,
-/*69*/  TOKENIZER_SIN,
-/*70*/  TOKENIZER_COS,
-/*71*/  TOKENIZER_TAN,
-/*72*/  TOKENIZER_EXP,
-/*73*/  TOKENIZER_LN,
+/*100*/  TOKENIZER_TIC,
+/*101*/  TOKENIZER_TOC,
+#endif
+#if defined(UBASIC_HAVE_FLOATS)
+/*102*/  TOKENIZER_INT,
+/*103*/  TOKENIZER_FLOAT,
+/*104*/  TOKENIZER_SQRT,
+/*105*/  TOKENIZER_SIN,
+/*106*/  TOKENIZER_COS,
+/*107*/  TOKENIZER_TAN,
+/*108*/  TOKENIZER_EXP,
+/*109*/  TOKENIZER_LN,
   #if defined(UBASIC_SCRIPT_HAVE_RANDOM_NUMBER_GENERATOR)
-/*74*/  TOKENIZER_UNIFORM,
+/*110*/  TOKENIZER_UNIFORM,
+/*111*/  TOKENIZER_GAUSS,
   #endif
-/*75*/  TOKENIZER_ABS,
-/*76*/  TOKENIZER_FLOOR,
-/*77*/  TOKENIZER_CEIL,
-/*78*/  TOKENIZER_ROUND,
-/*79*/  TOKENIZER_POWER,
+/*112*/  TOKENIZER_ABS,
+/*113*/  TOKENIZER_FLOOR,
+/*114*/  TOKENIZER_CEIL,
+/*115*/  TOKENIZER_ROUND,
+/*116*/  TOKENIZER_POWER,
 #endif
 #if defined(UBASIC_SCRIPT_HAVE_HARDWARE_EVENTS)
-/*80*/  TOKENIZER_HWE,
+/*117*/  TOKENIZER_HWE,
 #endif
 #if defined(UBASIC_SCRIPT_HAVE_PWM_CHANNELS)
-/*81*/  TOKENIZER_PWMCONF,
-/*82*/  TOKENIZER_PWM,
+/*118*/  TOKENIZER_PWMCONF,
+/*119*/  TOKENIZER_PWM,
 #endif
 #if defined(UBASIC_SCRIPT_HAVE_ANALOG_READ)
-/*83*/  TOKENIZER_AREADCONF,
-/*84*/  TOKENIZER_AREAD,
+/*120*/  TOKENIZER_AREADCONF,
+/*121*/  TOKENIZER_AREAD,
 #endif
-/*85*/  TOKENIZER_LABEL,
-/*86*/  TOKENIZER_COLON,
+/*122*/  TOKENIZER_LABEL,
+/*123*/  TOKENIZER_COLON,
 #if defined(UBASIC_SCRIPT_HAVE_STORE_VARS_IN_FLASH)
-/*87*/  TOKENIZER_STORE,
-/*88*/  TOKENIZER_RECALL,
+/*124*/  TOKENIZER_STORE,
+/*125*/  TOKENIZER_RECALL,
 #endif
-/*89*/  TOKENIZER_CLEAR,
+/*126*/  TOKENIZER_CLEAR,
   //
   // Plus: End
   // 
@@ -177,7 +224,7 @@ uint8_t tokenizer_token(void);
 VARIABLE_TYPE tokenizer_num(void);
 VARIABLE_TYPE tokenizer_int(void);
 
-#ifdef FIXEDPT_FBITS
+#if defined(UBASIC_HAVE_FLOATS)
 VARIABLE_TYPE tokenizer_float(void);
 #endif
 
@@ -187,7 +234,8 @@ uint8_t tokenizer_finished(void);
 void tokenizer_error_print(VARIABLE_TYPE token);
 
 #if defined(VARIABLE_TYPE_STRING)
-void tokenizer_string(char *dest, uint8_t len);
+uint16_t tokenizer_string(char *dest, uint16_t len);
+uint16_t tokenizer_stringlen(void);
 // string addition
 int8_t tokenizer_stringlookahead(void);
 // end of string addition
@@ -32,6 +32,14 @@
 #include "config.h"
 #include "ubasic.h"
 #include "tokenizer.h"
+#include "numconv.h"
+
+/* text to integer at the width of VARIABLE_TYPE */
+#if defined(VARIABLE_STORAGE_INT64)
+#define ubasic_atoi(s)  atoll(s)
+#else
+#define ubasic_atoi(s)  atoi(s)
+#endif
 
 /**
   * uBASIC Global and Exported Variables: Start
@@ -46,9 +54,67 @@ uint8_t   input_how=0;
  */
 
 #if defined(VARIABLE_TYPE_ARRAY)
-static VARIABLE_TYPE  arrays_data[VARIABLE_TYPE_ARRAY] = {0};
-static int16_t        free_arrayptr = 0;
+/* unsigned integer as wide as an entry */
+#if defined(VARIABLE_STORAGE_INT64)
+#define ARRAY_UVAR            uint64_t
+#else
+#define ARRAY_UVAR            uint32_t
+#endif
+/* an entry of the array storage: the elements of plain arrays are values
+   (v), while headers, ring positions and the bytes of packed arrays are
+   integers (w), so that none of them is ever loaded as a native float */
+typedef union
+{
+  VARIABLE_TYPE v;
+  ARRAY_UVAR    w;
+} array_entry_t;
+static array_entry_t  arrays_data[VARIABLE_TYPE_ARRAY] = {{0}};
+/* the 32 bits of a header entry, and the entry holding them */
+#define ARRAY_BITS(h)         ( (uint32_t) (h).w )
+#define ARRAY_WORD(u)         ( (array_entry_t) { .w = (u) } )
+/* array block header, see ubasic_dim_arrayvariable() */
+#define ARRAY_FREE            0x1f
+#define ARRAY_HDR(v,n)        ARRAY_WORD( ((uint32_t) (v)<<16) | (uint16_t) (n) )
+#define ARRAY_HDR_FULL(v,n,c,t) ARRAY_WORD( ((uint32_t) (c)<<24) | ((uint32_t) (t)<<21) | \
+                                          ((uint32_t) (v)<<16) | (uint16_t) (n) )
+#define ARRAY_HDR_VARNUM(h)   ( (uint8_t) ((ARRAY_BITS(h)>>16) & 0x1f) )
+#define ARRAY_HDR_KIND(h)     ( (uint8_t) ((ARRAY_BITS(h)>>21) & 0x07) )
+#define ARRAY_HDR_TYPE(h)     ( (uint8_t) ((ARRAY_BITS(h)>>21) & 0x03) )
+#define ARRAY_HDR_RING(h)     ( (uint8_t) ((ARRAY_BITS(h)>>23) & 0x01) )
+#define ARRAY_HDR_COLS(h)     ( (uint8_t) (ARRAY_BITS(h)>>24) )
+#define ARRAY_HDR_SIZE(h)     ( (uint16_t) ARRAY_BITS(h) )
+#define ARRAY_HDR_WORDS(h)    ( arrays_words(ARRAY_HDR_SIZE(h), ARRAY_HDR_TYPE(h)) + ARRAY_HDR_RING(h) )
+#define ARRAY_IS_FREE(p)      ( ARRAY_HDR_VARNUM(arrays_data[p]) == ARRAY_FREE )
+#define ARRAY_NEXT(p)         ( (p) + ARRAY_HDR_WORDS(arrays_data[p]) + 1 )
+#define ARRAY_DATA(p)         ( (p) + 1 + ARRAY_HDR_RING(arrays_data[p]) )
+/* ring arrays: the entry after the header holds [ 31:16 count, 15:0 head ] */
+#define RING_STATE(c,h)       ARRAY_WORD( ((uint32_t) (c)<<16) | (uint16_t) (h) )
+#define RING_COUNT(p)         ( (uint16_t) (ARRAY_BITS(arrays_data[(p)+1])>>16) )
+#define RING_HEAD(p)          ( (uint16_t) ARRAY_BITS(arrays_data[(p)+1]) )
 static int16_t        arrayvariable[MAX_VARNUM] = {-1};
+static void           arrays_init(void);
+static uint16_t       arrays_index_2d(uint8_t, VARIABLE_TYPE, VARIABLE_TYPE);
+static uint16_t       arrays_words(uint16_t, uint8_t);
+static VARIABLE_TYPE  arrays_reduce(uint8_t, uint8_t, uint8_t);
+static VARIABLE_TYPE  arrays_find(uint8_t, VARIABLE_TYPE);
+static void           arrays_sort_all(uint8_t, uint8_t);
+static void           arrays_fill(uint8_t, VARIABLE_TYPE);
+static uint8_t        arrays_shift(uint8_t, int32_t, uint8_t);
+static uint8_t        arrays_push(uint8_t, VARIABLE_TYPE);
+static uint8_t        arrays_filter_init(uint8_t, uint8_t, uint8_t);
+static uint8_t        arrays_filter(uint8_t, VARIABLE_TYPE *);
+static uint8_t        arrays_matrix(uint8_t, uint8_t, uint8_t, uint8_t);
+static VARIABLE_TYPE  arrays_interp(VARIABLE_TYPE, uint8_t, uint8_t);
+static VARIABLE_TYPE  arrays_polyval(VARIABLE_TYPE, uint8_t);
+#if defined(UBASIC_SCRIPT_HAVE_FFT)
+static uint8_t        arrays_fft(uint8_t, uint8_t, uint8_t);
+static void           arrays_mag(uint8_t, uint8_t, uint8_t);
+#endif
+static VARIABLE_TYPE  arrays_pop(uint8_t);
+#if defined(UBASIC_SCRIPT_HAVE_RANDOM_NUMBER_GENERATOR)
+static void           arrays_rand(uint8_t, VARIABLE_TYPE, VARIABLE_TYPE);
+#endif
+static uint8_t        arrays_copy(uint8_t, uint8_t, VARIABLE_TYPE *);
 #endif
 
 
@@ -90,30 +156,80 @@ static void statement(void);
 static char stringstack[MAX_BUFFERLEN];
 static int16_t freebufptr = 0;
 static int16_t stringvariables[MAX_SVARNUM];
+#if defined(VARIABLE_TYPE_STRING_ARRAY)
+/* string arrays: size followed by size offsets into stringstack */
+static int16_t sarrays_data[VARIABLE_TYPE_STRING_ARRAY];
+static int16_t free_sarrayptr = 0;
+static int16_t sarrayvariable[MAX_SVARNUM];
+#endif
 static int16_t sexpr(void);
 static int16_t scpy(char *);
-static int16_t sconcat(char *, char *);
-static int16_t sleft(char *, int16_t);
-static int16_t sright(char *,int16_t);
-static int16_t smid(char *, int16_t, int16_t);
+static int16_t sconcat(int16_t, int16_t);
+static int16_t sleft(int16_t, int16_t);
+static int16_t sright(int16_t,int16_t);
+static int16_t smid(int16_t, int16_t, int16_t);
 static int16_t sstr(VARIABLE_TYPE j);
 static int16_t schr(VARIABLE_TYPE j);
-static uint8_t sinstr(uint16_t, char*, char*);
-/* two special macros for handling strings and their headers on stack */
-#define STRVAR(s) ( (uint8_t) *(stringstack+(s)) )
-#define STRPTR(s) ( (char*) (stringstack+(s)+1) )
+static uint16_t sinstr(uint16_t, int16_t, int16_t);
+static int16_t sfield(int16_t, VARIABLE_TYPE, int16_t);
+/* strings on stack are stored as
+ *    header: reference count (1 byte, number of variables pointing to
+ *              the string, 0 if temporary),
+ *            length (STRING_LEN_TYPE, 1 or 2 bytes LSB first)
+ *    data:   length chars followed by '\0'
+ * so that the length never has to be searched for. Offset -1 stands for
+ * an empty string which does not occupy any space on stack.
+ * Strings are never changed in place, so that assignment of one variable
+ * to another only shares the string: a copy is made only if the reference
+ * count would overflow. */
+#define STRHDRLEN   (1 + sizeof(STRING_LEN_TYPE))
+#define STRREF(s)   ( *((uint8_t *) stringstack+(s)) )
+#define STRREF_MAX  255
+static void sassign(int16_t *, int16_t);
+#define STRPTR(s)   ( sptr(s) )
+#define STRLEN(s)   ( slen(s) )
+#define STRSIZE(s)  ( STRHDRLEN + slen(s) + 1 )
+static inline char * sptr(int16_t s)
+{
+  if (s < 0)
+    return ((char *) "");
+  return ((char *) (stringstack + s + STRHDRLEN));
+}
+static inline uint16_t slen(int16_t s)
+{
+  if (s < 0)
+    return 0;
+#if (MAX_STRINGLEN > 255)
+  return ( ((uint8_t) stringstack[s+1]) | (((uint16_t) (uint8_t) stringstack[s+2])<<8) );
+#else
+  return ( (uint8_t) stringstack[s+1] );
+#endif
+}
+#if (MAX_STRINGLEN > 255)
+  #define STRLEN_SET(s,l) { stringstack[(s)+1] = (l) & 0xff; stringstack[(s)+2] = (l) >> 8; }
+#else
+  #define STRLEN_SET(s,l) { stringstack[(s)+1] = (l); }
+#endif
 #endif
 
 #if defined(UBASIC_SCRIPT_HAVE_INPUT_FROM_SERIAL)
 static uint8_t input_varnum;
 static uint8_t input_type;
 #endif
-#if defined(VARIABLE_TYPE_ARRAY)
+#if defined(VARIABLE_TYPE_ARRAY) || defined(VARIABLE_TYPE_STRING_ARRAY)
 VARIABLE_TYPE  input_array_index;
 #endif
 
 #if defined(UBASIC_SCRIPT_HAVE_STORE_VARS_IN_FLASH)
 static VARIABLE_TYPE recall_statement(void);
+#if defined(VARIABLE_TYPE_STRING)
+/* flash records carry at most 255 bytes of data including string padding */
+#if (MAX_STRINGLEN > 252)
+  #define MAX_FLASH_STRINGLEN 252
+#else
+  #define MAX_FLASH_STRINGLEN MAX_STRINGLEN
+#endif
+#endif
 #endif
 
 /*---------------------------------------------------------------------------*/
@@ -129,11 +245,11 @@ void ubasic_clear_variables()
   }
 
 #if defined(VARIABLE_TYPE_ARRAY)
-  free_arrayptr = 0;
   for (i=0; i<VARIABLE_TYPE_ARRAY; i++)
   {
-    arrays_data[i] = 0;
+    arrays_data[i].w = 0;
   }
+  arrays_init();
 #endif
 
 #if defined(VARIABLE_TYPE_STRING)
@@ -141,6 +257,12 @@ void ubasic_clear_variables()
   for (i=0; i<MAX_SVARNUM; i++)
     stringvariables[i] = -1;
 #endif
+
+#if defined(VARIABLE_TYPE_STRING_ARRAY)
+  free_sarrayptr = 0;
+  for (i=0; i<MAX_SVARNUM; i++)
+    sarrayvariable[i] = -1;
+#endif
 }
 
 /*---------------------------------------------------------------------------*/
@@ -177,9 +299,11 @@ static uint8_t accept(VARIABLE_TYPE token)
 /*---------------------------------------------------------------------------*/
 static void accept_cr()
 {
+  // the tokenizer does not advance anymore after an error
   while ( (tokenizer_token() != TOKENIZER_EOL) &&
            (tokenizer_token() != TOKENIZER_ERROR) &&
-           (tokenizer_token() != TOKENIZER_ENDOFINPUT) )
+           (tokenizer_token() != TOKENIZER_ENDOFINPUT) &&
+           !ubasic_status.bit.Error )
   {
     tokenizer_next();
   }
@@ -193,9 +317,9 @@ static void accept_cr()
 /*---------------------------------------------------------------------------*/
 uint8_t string_space_check(uint16_t l)
 {
-   // returns true if not enough room for new string
+   // returns true if not enough room for new string of length l
   uint8_t i;
-  i = ((MAX_BUFFERLEN - freebufptr) <= (l + 2)); // +2 to play it safe
+  i = ((uint16_t) (MAX_BUFFERLEN - freebufptr) < (uint16_t) (l + STRHDRLEN + 1));
   if (i)
   {
     ubasic_status.bit.isRunning = 0;
@@ -204,11 +328,56 @@ uint8_t string_space_check(uint16_t l)
   return i;
 }
 
+/*---------------------------------------------------------------------------*/
+// how long a string can be written in place at the end of stringstack
+static uint16_t string_space_left(void)
+{
+  int16_t l = MAX_BUFFERLEN - freebufptr - STRHDRLEN - 1;
+  if (l < 0)
+    return 0;
+  if (l > MAX_STRINGLEN)
+    return MAX_STRINGLEN;
+  return l;
+}
+
+/*---------------------------------------------------------------------------*/
+// move nref references to the string at offset 'from' to offset 'to'
+static void sreloc(int16_t from, int16_t to, uint8_t nref)
+{
+  int16_t i;
+
+  for (i=0; (i<MAX_SVARNUM) && nref; i++)
+  {
+    if (stringvariables[i] == from)
+    {
+      stringvariables[i] = to;
+      nref--;
+    }
+  }
+
+#if defined(VARIABLE_TYPE_STRING_ARRAY)
+  // skip the size entry at the beginning of each array
+  int16_t j, n;
+  for (i=0; (i<free_sarrayptr) && nref; i+=n+1)
+  {
+    n = sarrays_data[i];
+    for (j=i+1; j<=i+n; j++)
+    {
+      if (sarrays_data[j] == from)
+      {
+        sarrays_data[j] = to;
+        nref--;
+      }
+    }
+  }
+#endif
+}
+
 /*---------------------------------------------------------------------------*/
 void clear_stringstack(void)
 {
-  // if (!ubasic_status.bit.stringstackModified )
-    // return;
+  if (!ubasic_status.bit.stringstackModified )
+    return;
 
   ubasic_status.bit.stringstackModified = 0;
 
@@ -216,211 +385,203 @@ void clear_stringstack(void)
   int16_t len = 0;
 
   // find bottom of the stringstack skip allocated stringstack space
-  while ( *(stringstack+bottom) != 0 )
+  while ( (bottom < freebufptr) && STRREF(bottom) )
   {
-    bottom += strlen( STRPTR(bottom) ) + 2;
-    if (freebufptr == bottom)
-      return;
+    bottom += STRSIZE(bottom);
   }
 
   int16_t top = bottom;
-  do
+  while (top < freebufptr)
   {
-    len = strlen( STRPTR(top) ) + 2;
+    len = STRSIZE(top);
 
-    if ( *(stringstack+top) > 0 )
+    if ( STRREF(top) )
     {
       // moving stuff down
-      for (uint8_t i=0; i<=len; i++)
-        *(stringstack+bottom+i) = *(stringstack+top+i);
+      memmove(stringstack+bottom, stringstack+top, len);
 
-      // update variable reference from top to bottom
-      stringvariables[ *(stringstack+bottom) - 1 ] = bottom;
+      // update all variable references from top to bottom
+      sreloc(top, bottom, STRREF(bottom));
 
       bottom += len;
     }
     top += len;
   }
-  while(top < freebufptr);
 
   freebufptr = bottom;
   return;
- }
+}
 /*---------------------------------------------------------------------------*/
-// copy s1 at the end of stringstack and add a header
-static int16_t scpy(char *s1)
+// complete the header of the string of length l that has been written in
+// place at the end of stringstack
+static int16_t sfinish(uint16_t l)
 {
-  if (!s1)
-    return (-1);
-
   int16_t bp = freebufptr;
-  int16_t l = strlen(s1);
-
-  if (!l)
-    return (-1);
-
-  if (string_space_check(l))
-    return (-1);
 
   ubasic_status.bit.stringstackModified = 1;
 
   *(stringstack+bp) = 0;
-  memcpy(stringstack+bp+1, s1, l+1);
+  STRLEN_SET(bp, l);
+  *(STRPTR(bp) + l) = 0;
 
-  freebufptr = bp + l + 2;
+  freebufptr = bp + STRHDRLEN + l + 1;
 
   return bp;
 }
+/*---------------------------------------------------------------------------*/
+// copy l chars of s1 at the end of stringstack and add a header
+static int16_t scpy_n(char *s1, uint16_t l)
+{
+  if (l > MAX_STRINGLEN)
+    l = MAX_STRINGLEN;
+
+  if (string_space_check(l))
+    return (-1);
+
+  memcpy(STRPTR(freebufptr), s1, l);
+
+  return sfinish(l);
+}
+/*---------------------------------------------------------------------------*/
+// copy s1 at the end of stringstack and add a header
+static int16_t scpy(char *s1)
+{
+  if (!s1)
+    return (-1);
+
+  return scpy_n(s1, strlen(s1));
+}
 
 /*---------------------------------------------------------------------------*/
 // return the concatenation of s1 and s2 in a string at the end
 // of the stringbuffer
-static int16_t sconcat(char *s1, char *s2)
+static int16_t sconcat(int16_t s1, int16_t s2)
 {
-  int16_t l1=strlen(s1), l2=strlen(s2);
+  uint16_t l1=STRLEN(s1), l2=STRLEN(s2);
+
+  if (l1 + l2 > MAX_STRINGLEN)
+    l2 = MAX_STRINGLEN - l1;
 
   if (string_space_check(l1+l2))
      return (-1);
 
-  int16_t rp=scpy(s1);
-  freebufptr -= 2; // last char in s1, will be overwritten by s2 header
-  int16_t fp=freebufptr;
-  char dummy = *(stringstack + fp);
-  scpy(s2);
-  *(stringstack + fp) = dummy; // overwrite s2 header
-  return (rp);
+  char *d = STRPTR(freebufptr);
+  memcpy(d, STRPTR(s1), l1);
+  memcpy(d+l1, STRPTR(s2), l2);
+
+  return sfinish(l1+l2);
 }
 /*---------------------------------------------------------------------------*/
-static int16_t sleft(char *s1, int16_t l) // return the left l chars of s1
+static int16_t sleft(int16_t s1, int16_t l) // return the left l chars of s1
 {
-  int16_t bp = freebufptr;
-  int16_t rp = bp;
-
-  if (l<1)
-    return (-1);
-
-  if (string_space_check(l))
-    return (-1);
+  if (l<0)
+    l = 0;
 
-  ubasic_status.bit.stringstackModified = 1;
-
-  if (strlen(s1) <=l)
-  {
-    return scpy(s1);
-  }
-  else
-  {
-    // write header
-    *(stringstack + bp) = 0;
-    bp++;
-    memcpy(stringstack+bp, s1, l);
-    bp += l;
-    *(stringstack + bp) = 0;
-    freebufptr = bp + 1;
-  }
+  if (STRLEN(s1) <= l)
+    l = STRLEN(s1);
 
-  return rp;
+  return scpy_n(STRPTR(s1), l);
 }
 /*---------------------------------------------------------------------------*/
-static int16_t sright(char *s1, int16_t l) // return the right l chars of s1
+static int16_t sright(int16_t s1, int16_t l) // return the right l chars of s1
 {
-  int16_t j=strlen(s1);
+  int16_t j=STRLEN(s1);
 
-  if (l<1)
-    return (-1);
+  if (l<0)
+    l = 0;
 
   if (j <= l)
     l = j;
 
-  if (string_space_check(l))
-    return (-1);
-
-  return scpy(s1 + j - l);
+  return scpy_n(STRPTR(s1) + j - l, l);
 }
 
 /*---------------------------------------------------------------------------*/
-static int16_t smid(char *s1, int16_t l1, int16_t l2) // return the l2 chars of s1 starting at offset l1
+static int16_t smid(int16_t s1, int16_t l1, int16_t l2) // return the l2 chars of s1 starting at offset l1
 {
-  int16_t bp=freebufptr;
-  int16_t rp=bp;
-  int16_t i, j=strlen(s1);
-
-  if (l2<1 || l1>j)
-    return (-1);
-
-  if (string_space_check(l2))
-    return (-1);
-
-  if (l2 > j-l1)
-    l2 = j-l1;
+  int16_t j=STRLEN(s1);
 
-  ubasic_status.bit.stringstackModified = 1;
-
-  *(stringstack + bp) = 0;
-  bp++;
+  if (l1<1)
+    l1 = 1;
 
-  for (i=l1; i<l1+l2; i++)
-  {
-    *(stringstack + bp) = *(s1 + l1 -1);
-    bp++;
-    s1++;
-  }
+  if (l2<0 || l1>j)
+    l2 = 0;
+  else if (l2 > j-l1+1)
+    l2 = j-l1+1;
 
-  *(stringstack + bp) = '\0';
-  freebufptr = bp+1;
-  return rp;
+  return scpy_n(STRPTR(s1) + l1 - 1, l2);
 }
 /*---------------------------------------------------------------------------*/
 static int16_t sstr(VARIABLE_TYPE j) // return the integer j as a string
 {
-  int16_t bp=freebufptr;
-  int16_t rp=bp;
-
-  if (string_space_check(10))
+  if (string_space_check(NUMCONV_MAXLEN))
     return (-1);
 
-  ubasic_status.bit.stringstackModified = 1;
-
-  *(stringstack+bp) = 0;
-  bp++;
-
-  sprintf((char*)(stringstack+bp),"%ld",j);
-
-  freebufptr = bp + strlen((char*)(stringstack+bp)) + 1;
-
-  return rp;
+  return sfinish( numconv_dec(STRPTR(freebufptr), j) );
 }
 /*---------------------------------------------------------------------------*/
 static int16_t schr(VARIABLE_TYPE j) // return the character whose ASCII code is j
 {
-  int16_t bp=freebufptr;
-  int16_t rp=bp;
+  char c = j;
+  return scpy_n(&c, 1);
+}
+/*---------------------------------------------------------------------------*/
+// copy string literal from the script directly to stringstack: a literal
+// that is longer than a string or does not fit stops the script
+static int16_t sliteral(void)
+{
+  uint16_t l = tokenizer_stringlen();
 
-  if (string_space_check(1))
+  if (l > MAX_STRINGLEN)
+  {
+    ubasic_status.bit.isRunning = 0;
+    ubasic_status.bit.Error = 1;
     return (-1);
+  }
 
-  ubasic_status.bit.stringstackModified = 1;
-
-  *(stringstack+bp) = 0;
-  bp++;
-
-  *(stringstack+bp) = j;
-  bp++;
-
-  *(stringstack+bp) = 0;
-  bp++;
+  if (string_space_check(l))
+    return (-1);
 
-  freebufptr = bp;
-  return rp;
+  return sfinish( tokenizer_string(STRPTR(freebufptr), l) );
 }
 /*---------------------------------------------------------------------------*/
-static uint8_t sinstr(uint16_t j, char *s, char *s1) // return the position of s1 in s (or 0)
+static uint16_t sinstr(uint16_t j, int16_t s, int16_t s1) // return the position of s1 in s (or 0)
 {
    char *p;
-   p = strstr(s+j, s1);
+   if (j > STRLEN(s))
+     return 0;
+   p = strstr(STRPTR(s)+j, STRPTR(s1));
    if (p == NULL)
       return 0;
-   return (p - s + 1);
+   return (p - STRPTR(s) + 1);
+}
+
+/*---------------------------------------------------------------------------*/
+// return field n (counted from 1) of s, fields being separated by any of
+// the characters in d, or an empty string if s has fewer fields
+static int16_t sfield(int16_t s, VARIABLE_TYPE n, int16_t d)
+{
+  char *p = STRPTR(s), *e = p + STRLEN(s);
+  uint16_t l;
+
+  if (n < 1)
+    return (-1);
+
+  while (1)
+  {
+    l = strcspn(p, STRPTR(d));
+    if (--n == 0)
+      break;
+    p += l;
+    if (p >= e)
+      return (-1);
+    p++;
+  }
+
+  if (l == 0)
+    return (-1);
+
+  return scpy_n(p, l);
 }
 
 /*---------------------------------------------------------------------------*/
@@ -428,7 +589,6 @@ int16_t sfactor()
 {
   // string form of factor
   int16_t r=0, s=0;
-  char tmpstring[MAX_STRINGLEN];
 
   VARIABLE_TYPE i, j;
 
@@ -441,8 +601,7 @@ int16_t sfactor()
       break;
 
     case TOKENIZER_STRING:
-      tokenizer_string(tmpstring, MAX_STRINGLEN);
-      r = scpy(tmpstring);
+      r = sliteral();
       accept(TOKENIZER_STRING);
       break;
 
@@ -452,10 +611,10 @@ int16_t sfactor()
       s = sexpr();
       accept(TOKENIZER_COMMA);
       i =relation();
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+  #if defined(UBASIC_HAVE_FLOATS)
       i = fixedpt_toint(i);
   #endif
-      r = sleft(STRPTR(s),i);
+      r = sleft(s,i);
       accept(TOKENIZER_RIGHTPAREN);
       break;
 
@@ -465,10 +624,10 @@ int16_t sfactor()
       s = sexpr();
       accept(TOKENIZER_COMMA);
       i =relation();
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+  #if defined(UBASIC_HAVE_FLOATS)
       i = fixedpt_toint(i);
   #endif
-      r = sright(STRPTR(s),i);
+      r = sright(s,i);
       accept(TOKENIZER_RIGHTPAREN);
       break;
 
@@ -478,29 +637,43 @@ int16_t sfactor()
       s = sexpr();
       accept(TOKENIZER_COMMA);
       i =relation();
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+  #if defined(UBASIC_HAVE_FLOATS)
       i = fixedpt_toint(i);
   #endif
       if (tokenizer_token() == TOKENIZER_COMMA)
       {
         accept(TOKENIZER_COMMA);
         j =relation();
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+  #if defined(UBASIC_HAVE_FLOATS)
         j = fixedpt_toint(j);
   #endif
       }
       else
       {
-        j = 999; // ensure we get all of it
+        j = MAX_STRINGLEN; // ensure we get all of it
       }
-      r = smid(STRPTR(s),i,j);
+      r = smid(s,i,j);
+      accept(TOKENIZER_RIGHTPAREN);
+      break;
+
+    case TOKENIZER_FIELD$:
+      accept(TOKENIZER_FIELD$);
+      accept(TOKENIZER_LEFTPAREN);
+      s = sexpr();
+      accept(TOKENIZER_COMMA);
+      i =relation();
+  #if defined(UBASIC_HAVE_FLOATS)
+      i = fixedpt_toint(i);
+  #endif
+      accept(TOKENIZER_COMMA);
+      r = sfield(s, i, sexpr());
       accept(TOKENIZER_RIGHTPAREN);
       break;
 
     case TOKENIZER_STR$:
       accept(TOKENIZER_STR$);
       j =relation();
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+  #if defined(UBASIC_HAVE_FLOATS)
       j = fixedpt_toint(j);
   #endif
       r = sstr(j);
@@ -509,7 +682,7 @@ int16_t sfactor()
     case TOKENIZER_CHR$:
       accept(TOKENIZER_CHR$);
       j =relation();
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+  #if defined(UBASIC_HAVE_FLOATS)
       j = fixedpt_toint(j);
   #endif
       if (j<0 || j>255)
@@ -518,8 +691,22 @@ int16_t sfactor()
       break;
 
     default:
-      r = ubasic_get_stringvariable(tokenizer_variable_num());
+      i = tokenizer_variable_num();
       accept(TOKENIZER_STRINGVARIABLE);
+#if defined(VARIABLE_TYPE_STRING_ARRAY)
+      if (tokenizer_token() == TOKENIZER_LEFTPAREN)
+      {
+        accept(TOKENIZER_LEFTPAREN);
+        j = relation();
+  #if defined(UBASIC_HAVE_FLOATS)
+        j = fixedpt_toint(j);
+  #endif
+        accept(TOKENIZER_RIGHTPAREN);
+        r = ubasic_get_stringarrayvariable(i, (uint16_t) j);
+        break;
+      }
+#endif
+      r = ubasic_get_stringvariable(i);
   }
 
   return r;
@@ -536,7 +723,7 @@ static int16_t sexpr( void ) // string form of expr
   {
     tokenizer_next();
     s2 = sfactor();
-    s1 = sconcat(STRPTR(s1),STRPTR(s2));
+    s1 = sconcat(s1,s2);
     op = tokenizer_token();
   }
   return s1;
@@ -552,63 +739,275 @@ static uint8_t slogexpr() // string logical expression
    if(op == TOKENIZER_EQ)
    {
      s2 = sexpr();
-     r = (strcmp(STRPTR(s1),STRPTR(s2)) == 0);
+     r = (STRLEN(s1) == STRLEN(s2)) &&
+            (memcmp(STRPTR(s1),STRPTR(s2),STRLEN(s1)) == 0);
    }
    return r;
 }
 // end of string additions
 #endif
 
+#if defined(VARIABLE_TYPE_ARRAY)
 /*---------------------------------------------------------------------------*/
-static VARIABLE_TYPE varfactor(void)
+// parse (i) or (r,c) following the array varnum: returns the index of the
+// element in the array, 0 if it is out of range
+static uint16_t array_index(uint8_t varnum)
 {
-  VARIABLE_TYPE r;
-  r = ubasic_get_variable(tokenizer_variable_num());
-  accept(TOKENIZER_VARIABLE);
-  return r;
+  VARIABLE_TYPE i, j;
+
+  accept(TOKENIZER_LEFTPAREN);
+  i = relation();
+#if defined(UBASIC_HAVE_FLOATS)
+  i = fixedpt_toint(i);
+#endif
+  if (tokenizer_token() == TOKENIZER_COMMA)
+  {
+    accept(TOKENIZER_COMMA);
+    j = relation();
+#if defined(UBASIC_HAVE_FLOATS)
+    j = fixedpt_toint(j);
+#endif
+    i = arrays_index_2d(varnum, i, j);
+  }
+  accept(TOKENIZER_RIGHTPAREN);
+
+  if ( (i < 1) || (i > 0xffff) )
+    return 0;
+  return (uint16_t) i;
 }
+
 /*---------------------------------------------------------------------------*/
-static VARIABLE_TYPE factor(void)
+// array as a whole, a@ or a@(), as the result of a bulk array statement
+// that dimensions it: returns its varnum
+static uint8_t array_target(void)
 {
-  VARIABLE_TYPE r;
-  // string function additions
-  VARIABLE_TYPE i, j;
-#if defined(VARIABLE_TYPE_ARRAY)
-  uint8_t varnum;
+  uint8_t varnum = 0, token = tokenizer_token();
+
+  if (token == TOKENIZER_ARRAYVARIABLE)
+    varnum = tokenizer_variable_num();
+  tokenizer_next();
+  if (tokenizer_token() == TOKENIZER_LEFTPAREN)
+  {
+    accept(TOKENIZER_LEFTPAREN);
+    accept(TOKENIZER_RIGHTPAREN);
+  }
+
+  if (token != TOKENIZER_ARRAYVARIABLE)
+  {
+    tokenizer_error_print(token);
+    ubasic_status.bit.isRunning = 0;
+    ubasic_status.bit.Error = 1;
+  }
+  return varnum;
+}
+
+// the same as argument of the bulk array functions: it is an error if it
+// has not been dimensioned
+static uint8_t array_argument(void)
+{
+  uint8_t token = tokenizer_token(), varnum = array_target();
+
+  if ( !ubasic_status.bit.Error && (arrayvariable[varnum] < 0) )
+  {
+    tokenizer_error_print(token);
+    ubasic_status.bit.isRunning = 0;
+    ubasic_status.bit.Error = 1;
+  }
+  return varnum;
+}
 #endif
-#if defined(VARIABLE_TYPE_STRING)
-  int16_t s, s1;
+
+#if defined(UBASIC_SCRIPT_HAVE_RANDOM_NUMBER_GENERATOR)
+/*---------------------------------------------------------------------------*/
+// span times a random number uniform in [0,1): the fraction bits come
+// straight from RandomUInt32(). Without floats the result is a whole
+// number from 0 to span-1.
+static VARIABLE_TYPE random_uniform(VARIABLE_TYPE span)
+{
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+  return span * ((VARIABLE_TYPE) RandomUInt32(FIXEDPT_WBITS) / ((uint64_t) 1 << FIXEDPT_WBITS));
+#elif defined(UBASIC_HAVE_FIXEDPT_FLOATS)
+  return fixedpt_xmul(span, (VARIABLE_TYPE) RandomUInt32(FIXEDPT_FBITS) & FIXEDPT_FMASK);
+#elif defined(VARIABLE_STORAGE_INT64)
+  uint32_t u = RandomUInt32(32);
+  return (span >> 32) * u + (VARIABLE_TYPE) (((uint64_t) (span & 0xffffffff) * u) >> 32);
+#else
+  return (VARIABLE_TYPE) (((int64_t) span * RandomUInt32(32)) >> 32);
 #endif
+}
 
-  switch(tokenizer_token())
+#if defined(UBASIC_HAVE_FLOATS)
+// standard normal random numbers by the Box-Muller transform, of which the
+// radius sqrt(-2 ln u) and the angle 2 pi v use the table seeded ln, sqrt,
+// sin and cos; every second call returns the sine half of the previous
+// pair. GAUSS_BITS random bits for u keep the numbers within 4.7 of 0.
+#define GAUSS_BITS  16
+static VARIABLE_TYPE random_gauss(void)
+{
+  static VARIABLE_TYPE spare;
+  static uint8_t have_spare = 0;
+  VARIABLE_TYPE r, a;
+
+  if (have_spare)
   {
-#if defined(VARIABLE_TYPE_STRING)
+    have_spare = 0;
+    return spare;
+  }
 
-    case TOKENIZER_LEN:
-      accept(TOKENIZER_LEN);
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
-      r = fixedpt_fromint( strlen( STRPTR(sexpr()) ) );
-  #else
-      r = strlen( STRPTR(sexpr()) );
-  #endif
+  // ln(k / 2^GAUSS_BITS) for k = 1 to 2^GAUSS_BITS
+  r = fixedpt_ln( fixedpt_fromint(RandomUInt32(GAUSS_BITS) + 1) ) -
+      fixedpt_rconst(GAUSS_BITS * 0.69314718055994530942);
+  if (r > 0)
+    r = 0;
+  r = fixedpt_sqrt(-2 * r);
+  a = random_uniform(FIXEDPT_TWO_PI);
+
+  spare = fixedpt_xmul(r, fixedpt_sin(a));
+  have_spare = 1;
+  return fixedpt_xmul(r, fixedpt_cos(a));
+}
+#endif
+#endif
+
+#if defined(UBASIC_SCRIPT_HAVE_BIT_OPERATIONS)
+/*---------------------------------------------------------------------------*/
+// shl(x,n), shr(x,n), bit(x,n), setbit(x,n), clrbit(x,n), popcount(x) and
+// clz(x) on the whole part of x as a two's complement integer of the width
+// of VARIABLE_TYPE, without multiplications or divisions. shr keeps the
+// sign, and n outside 0 to BITS_WIDTH-1 shifts all bits out.
+#if defined(VARIABLE_STORAGE_INT64)
+#define BITS_INT          int64_t
+#define BITS_UINT         uint64_t
+#define BITS_POPCOUNT(x)  __builtin_popcountll(x)
+#define BITS_CLZ(x)       __builtin_clzll(x)
+#elif defined(VARIABLE_STORAGE_INT16)
+#define BITS_INT          int16_t
+#define BITS_UINT         uint16_t
+#define BITS_POPCOUNT(x)  __builtin_popcount(x)
+#define BITS_CLZ(x)       (__builtin_clz(x) - 16)
+#else
+#define BITS_INT          int32_t
+#define BITS_UINT         uint32_t
+#define BITS_POPCOUNT(x)  __builtin_popcount(x)
+#define BITS_CLZ(x)       __builtin_clz(x)
+#endif
+#define BITS_WIDTH        (8 * sizeof(BITS_INT))
+#if defined(UBASIC_HAVE_FLOATS)
+#define BITS_WHOLE(r)     ( (BITS_INT) fixedpt_toint(r) )
+#else
+#define BITS_WHOLE(r)     ( (BITS_INT) (r) )
+#endif
+
+static VARIABLE_TYPE bits_function(void)
+{
+  uint8_t token = tokenizer_token();
+  BITS_INT x;
+  BITS_UINT n = 0;
+
+  tokenizer_next();
+  accept(TOKENIZER_LEFTPAREN);
+  x = BITS_WHOLE( relation() );
+  if ( (token != TOKENIZER_POPCOUNT) && (token != TOKENIZER_CLZ) )
+  {
+    accept(TOKENIZER_COMMA);
+    n = (BITS_UINT) BITS_WHOLE( relation() );
+  }
+  accept(TOKENIZER_RIGHTPAREN);
+
+  switch (token)
+  {
+    case TOKENIZER_SHL:
+      x = (n < BITS_WIDTH) ? (BITS_INT) ((BITS_UINT) x << n) : 0;
       break;
 
+    case TOKENIZER_SHR:
+      if (n < BITS_WIDTH)
+        x >>= n;
+      else
+        x = (x < 0) ? -1 : 0;
+      break;
 
-    case TOKENIZER_VAL:
-      accept(TOKENIZER_VAL);
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
-      s1 = sexpr();
-      r  = str_fixedpt( STRPTR(s1), strlen( STRPTR(s1) ), 3);
-  #else
-      r = atoi( STRPTR(sexpr()) );
-  #endif
+    case TOKENIZER_BIT:
+      x = (n < BITS_WIDTH) ? (((BITS_UINT) x >> n) & 1) : 0;
       break;
 
+    case TOKENIZER_SETBIT:
+      if (n < BITS_WIDTH)
+        x = (BITS_INT) ((BITS_UINT) x | ((BITS_UINT) 1 << n));
+      break;
 
-    case TOKENIZER_ASC:
+    case TOKENIZER_CLRBIT:
+      if (n < BITS_WIDTH)
+        x = (BITS_INT) ((BITS_UINT) x & ~((BITS_UINT) 1 << n));
+      break;
+
+    case TOKENIZER_POPCOUNT:
+      x = BITS_POPCOUNT((BITS_UINT) x);
+      break;
+
+    default: // TOKENIZER_CLZ
+      x = (x) ? BITS_CLZ((BITS_UINT) x) : BITS_WIDTH;
+      break;
+  }
+
+#if defined(UBASIC_HAVE_FLOATS)
+  return fixedpt_fromint(x);
+#else
+  return x;
+#endif
+}
+#endif
+
+/*---------------------------------------------------------------------------*/
+static VARIABLE_TYPE varfactor(void)
+{
+  VARIABLE_TYPE r;
+  r = ubasic_get_variable(tokenizer_variable_num());
+  accept(TOKENIZER_VARIABLE);
+  return r;
+}
+/*---------------------------------------------------------------------------*/
+static VARIABLE_TYPE factor(void)
+{
+  VARIABLE_TYPE r;
+  // string function additions
+  VARIABLE_TYPE i, j;
+#if defined(VARIABLE_TYPE_ARRAY)
+  uint8_t varnum, token;
+#endif
+#if defined(VARIABLE_TYPE_STRING)
+  int16_t s, s1;
+#endif
+
+  switch(tokenizer_token())
+  {
+#if defined(VARIABLE_TYPE_STRING)
+
+    case TOKENIZER_LEN:
+      accept(TOKENIZER_LEN);
+  #if defined(UBASIC_HAVE_FLOATS)
+      r = fixedpt_fromint( STRLEN(sexpr()) );
+  #else
+      r = STRLEN(sexpr());
+  #endif
+      break;
+
+
+    case TOKENIZER_VAL:
+      accept(TOKENIZER_VAL);
+  #if defined(UBASIC_HAVE_FLOATS)
+      s1 = sexpr();
+      r  = str_fixedpt( STRPTR(s1), STRLEN(s1), 3);
+  #else
+      r = ubasic_atoi( STRPTR(sexpr()) );
+  #endif
+      break;
+
+
+    case TOKENIZER_ASC:
       accept(TOKENIZER_ASC);
       s = sexpr();
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+  #if defined(UBASIC_HAVE_FLOATS)
       r = fixedpt_fromint( *STRPTR(s) );
   #else
       r = *STRPTR(s);
@@ -632,8 +1031,8 @@ static VARIABLE_TYPE factor(void)
       accept(TOKENIZER_COMMA);
       s1 = sexpr();
       accept(TOKENIZER_RIGHTPAREN);
-      r = sinstr(j, STRPTR(s), STRPTR(s1));
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+      r = sinstr(j, s, s1);
+  #if defined(UBASIC_HAVE_FLOATS)
       r = fixedpt_fromint(r);
   #endif
       break;
@@ -652,7 +1051,11 @@ static VARIABLE_TYPE factor(void)
 
     case TOKENIZER_NOT:
       accept(TOKENIZER_LNOT);
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+      r = nativefp_fromraw( ~ nativefp_toraw( relation() ) );
+#else
       r = ~ relation();
+#endif
       break;
 
 #if defined(UBASIC_SCRIPT_HAVE_TICTOC)
@@ -660,7 +1063,7 @@ static VARIABLE_TYPE factor(void)
       accept(TOKENIZER_TOC);
       accept(TOKENIZER_LEFTPAREN);
       r =relation();
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+  #if defined(UBASIC_HAVE_FLOATS)
       r = fixedpt_toint(r);
   #endif
       if (r == 2)
@@ -675,7 +1078,7 @@ static VARIABLE_TYPE factor(void)
         r = ubasic_script_tic5_ms;
       else
         r = ubasic_script_tic0_ms;
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+  #if defined(UBASIC_HAVE_FLOATS)
       r = fixedpt_fromint(r);
       accept(TOKENIZER_RIGHTPAREN);
   #endif
@@ -688,15 +1091,15 @@ static VARIABLE_TYPE factor(void)
       accept(TOKENIZER_HWE);
       accept(TOKENIZER_LEFTPAREN);
       r = relation();
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+  #if defined(UBASIC_HAVE_FLOATS)
       r = fixedpt_toint(r);
   #endif
       if (r)
       {
-        if ( hw_event & (1<<(r-1)) )
+        if ( hw_event & (1<<((uint8_t) r-1)) )
         {
-          hw_event -= 0x01<<(r-1);
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+          hw_event -= 0x01<<((uint8_t) r-1);
+  #if defined(UBASIC_HAVE_FLOATS)
           r = FIXEDPT_ONE;
   #endif
         }
@@ -711,7 +1114,7 @@ static VARIABLE_TYPE factor(void)
 #if defined(UBASIC_SCRIPT_HAVE_RANDOM_NUMBER_GENERATOR)
     case TOKENIZER_RAN:
       accept(TOKENIZER_RAN);
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+  #if defined(UBASIC_HAVE_FLOATS)
       r = RandomUInt32(FIXEDPT_WBITS);
       r = fixedpt_fromint(r);
   #else
@@ -722,6 +1125,18 @@ static VARIABLE_TYPE factor(void)
       break;
 #endif
 
+#if defined(UBASIC_SCRIPT_HAVE_BIT_OPERATIONS)
+    case TOKENIZER_SHL:
+    case TOKENIZER_SHR:
+    case TOKENIZER_BIT:
+    case TOKENIZER_SETBIT:
+    case TOKENIZER_CLRBIT:
+    case TOKENIZER_POPCOUNT:
+    case TOKENIZER_CLZ:
+      r = bits_function();
+      break;
+#endif
+
     case TOKENIZER_ABS:
       accept(TOKENIZER_ABS);
       accept(TOKENIZER_LEFTPAREN);
@@ -732,7 +1147,7 @@ static VARIABLE_TYPE factor(void)
       break;
 
 
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+#if defined(UBASIC_HAVE_FLOATS)
     case TOKENIZER_POWER:
       accept(TOKENIZER_POWER);
       accept(TOKENIZER_LEFTPAREN);
@@ -803,7 +1218,16 @@ static VARIABLE_TYPE factor(void)
   #if defined(UBASIC_SCRIPT_HAVE_RANDOM_NUMBER_GENERATOR)
     case TOKENIZER_UNIFORM:
       accept(TOKENIZER_UNIFORM);
-      r = RandomUInt32(FIXEDPT_FBITS) & FIXEDPT_FMASK;
+      r = random_uniform(FIXEDPT_ONE);
+      break;
+
+    case TOKENIZER_GAUSS:
+      accept(TOKENIZER_GAUSS);
+      accept(TOKENIZER_LEFTPAREN);
+      r = relation();
+      accept(TOKENIZER_COMMA);
+      r += fixedpt_xmul( relation(), random_gauss() );
+      accept(TOKENIZER_RIGHTPAREN);
       break;
   #endif
 
@@ -812,17 +1236,12 @@ static VARIABLE_TYPE factor(void)
       accept(TOKENIZER_FLOOR);
       accept(TOKENIZER_LEFTPAREN);
       r = relation();
-      if (r>=0)
-      {
-        r = r & (~FIXEDPT_FMASK);
-      }
-      else
-      {
-        uint32_t f = (r & FIXEDPT_FMASK);
-        r = r & (~FIXEDPT_FMASK);
-        if (f>0)
-          r -= FIXEDPT_ONE;
-      }
+  #if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+      r = NATIVEFP(floor)(r);
+  #else
+      // two's complement: masking the fraction rounds down either way
+      r = r & (~FIXEDPT_FMASK);
+  #endif
       accept(TOKENIZER_RIGHTPAREN);
       break;
 
@@ -831,17 +1250,12 @@ static VARIABLE_TYPE factor(void)
       accept(TOKENIZER_CEIL);
       accept(TOKENIZER_LEFTPAREN);
       r = relation();
-      if (r>=0)
-      {
-        uint32_t f = (r & FIXEDPT_FMASK);
-        r = r & (~FIXEDPT_FMASK);
-        if (f>0)
-          r += FIXEDPT_ONE;
-      }
-      else
-      {
-        r = r & (~FIXEDPT_FMASK);
-      }
+  #if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+      r = NATIVEFP(ceil)(r);
+  #else
+      if (r & FIXEDPT_FMASK)
+        r = (r & (~FIXEDPT_FMASK)) + FIXEDPT_ONE;
+  #endif
       accept(TOKENIZER_RIGHTPAREN);
       break;
 
@@ -850,19 +1264,17 @@ static VARIABLE_TYPE factor(void)
       accept(TOKENIZER_ROUND);
       accept(TOKENIZER_LEFTPAREN);
       r = relation();
-      uint32_t f = (r & FIXEDPT_FMASK);
-      if (r>=0)
+  #if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+      r = NATIVEFP(round)(r);
+  #else
       {
+        // halves away from zero
+        uint32_t f = (r & FIXEDPT_FMASK);
         r = r & (~FIXEDPT_FMASK);
-        if (f>=FIXEDPT_ONE_HALF)
+        if ( (r >= 0) ? (f >= FIXEDPT_ONE_HALF) : (f > FIXEDPT_ONE_HALF) )
           r += FIXEDPT_ONE;
       }
-      else
-      {
-        r = r & (~FIXEDPT_FMASK);
-        if (f<=FIXEDPT_ONE_HALF)
-          r -= FIXEDPT_ONE;
-      }
+  #endif
       accept(TOKENIZER_RIGHTPAREN);
       break;
 #endif /* #if defined(VARIABLE_TYPE_FLOAT_AS ... */
@@ -874,7 +1286,7 @@ static VARIABLE_TYPE factor(void)
 
     case TOKENIZER_NUMBER:
       r = tokenizer_num();
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+#if defined(UBASIC_HAVE_FLOATS)
       r = fixedpt_fromint(r);
 #endif
       accept(TOKENIZER_NUMBER);
@@ -887,7 +1299,7 @@ static VARIABLE_TYPE factor(void)
       accept(TOKENIZER_LEFTPAREN);
       // single argument: channel
       j = relation();
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+  #if defined(UBASIC_HAVE_FLOATS)
       j = fixedpt_toint(j);
   #endif
       if (j <1 || j>UBASIC_SCRIPT_HAVE_PWM_CHANNELS)
@@ -896,9 +1308,9 @@ static VARIABLE_TYPE factor(void)
       }
       else
       {
-        r = dutycycle_pwm_ch[j-1];
+        r = dutycycle_pwm_ch[(uint8_t) j-1];
       }
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+  #if defined(UBASIC_HAVE_FLOATS)
       r = fixedpt_fromint(r);
   #endif
       accept(TOKENIZER_RIGHTPAREN);
@@ -912,11 +1324,11 @@ static VARIABLE_TYPE factor(void)
       accept(TOKENIZER_LEFTPAREN);
       // single argument: channel as hex value
       j = relation();
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+  #if defined(UBASIC_HAVE_FLOATS)
       j = fixedpt_toint(j);
   #endif
       r = analogRead(j);
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+  #if defined(UBASIC_HAVE_FLOATS)
       r = fixedpt_fromint(r);
   #endif
       accept(TOKENIZER_RIGHTPAREN);
@@ -935,11 +1347,84 @@ static VARIABLE_TYPE factor(void)
     case TOKENIZER_ARRAYVARIABLE:
       varnum = tokenizer_variable_num();
       accept(TOKENIZER_ARRAYVARIABLE);
-      j = relation();
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
-      j = fixedpt_toint(j);
-  #endif
-      r = ubasic_get_arrayvariable(varnum , (uint16_t) j);
+      r = ubasic_get_arrayvariable(varnum, array_index(varnum));
+      break;
+
+    case TOKENIZER_ASUM:
+    case TOKENIZER_AMIN:
+    case TOKENIZER_AMAX:
+    case TOKENIZER_AMEAN:
+    case TOKENIZER_AMEDIAN:
+    case TOKENIZER_ADOT:
+      token = tokenizer_token();
+      tokenizer_next();
+      accept(TOKENIZER_LEFTPAREN);
+      varnum = array_argument();
+      i = varnum;
+      if (token == TOKENIZER_ADOT)
+      {
+        accept(TOKENIZER_COMMA);
+        i = array_argument();
+      }
+      accept(TOKENIZER_RIGHTPAREN);
+      r = arrays_reduce(token, varnum, (uint8_t) i);
+      break;
+
+    case TOKENIZER_POP:
+      accept(TOKENIZER_POP);
+      accept(TOKENIZER_LEFTPAREN);
+      varnum = array_argument();
+      accept(TOKENIZER_RIGHTPAREN);
+      r = arrays_pop(varnum);
+      break;
+
+    case TOKENIZER_FILTER:
+      accept(TOKENIZER_FILTER);
+      accept(TOKENIZER_LEFTPAREN);
+      varnum = array_argument();
+      accept(TOKENIZER_COMMA);
+      r = relation();
+      accept(TOKENIZER_RIGHTPAREN);
+      if ( !ubasic_status.bit.Error && arrays_filter(varnum, &r) )
+      {
+        tokenizer_error_print(TOKENIZER_FILTER);
+        ubasic_status.bit.isRunning = 0;
+        ubasic_status.bit.Error = 1;
+      }
+      break;
+
+    case TOKENIZER_INTERP:
+      accept(TOKENIZER_INTERP);
+      accept(TOKENIZER_LEFTPAREN);
+      r = relation();
+      accept(TOKENIZER_COMMA);
+      varnum = array_argument();
+      accept(TOKENIZER_COMMA);
+      i = array_argument();
+      accept(TOKENIZER_RIGHTPAREN);
+      if (!ubasic_status.bit.Error)
+        r = arrays_interp(r, varnum, (uint8_t) i);
+      break;
+
+    case TOKENIZER_POLYVAL:
+      accept(TOKENIZER_POLYVAL);
+      accept(TOKENIZER_LEFTPAREN);
+      r = relation();
+      accept(TOKENIZER_COMMA);
+      varnum = array_argument();
+      accept(TOKENIZER_RIGHTPAREN);
+      if (!ubasic_status.bit.Error)
+        r = arrays_polyval(r, varnum);
+      break;
+
+    case TOKENIZER_AFIND:
+      accept(TOKENIZER_AFIND);
+      accept(TOKENIZER_LEFTPAREN);
+      varnum = array_argument();
+      accept(TOKENIZER_COMMA);
+      r = relation();
+      accept(TOKENIZER_RIGHTPAREN);
+      r = arrays_find(varnum, r);
       break;
 #endif
 
@@ -947,7 +1432,11 @@ static VARIABLE_TYPE factor(void)
     case TOKENIZER_DREAD:
       accept(TOKENIZER_LEFTPAREN);
       r = relation();
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+      r = nativefp_fromraw( digitalRead(nativefp_toraw(r)) );
+#else
       r = digitalRead(r);
+#endif
       accept(TOKENIZER_RIGHTPAREN);
       break;
 #endif /* UBASIC_SCRIPT_HAVE_GPIO_CHANNELS */
@@ -980,7 +1469,7 @@ static VARIABLE_TYPE term(void)
 #endif
   {
     f1 = factor();
-    VARIABLE_TYPE op = tokenizer_token();
+    uint8_t op = tokenizer_token();
     while (op == TOKENIZER_ASTR || op == TOKENIZER_SLASH || op == TOKENIZER_MOD)
     {
       tokenizer_next();
@@ -989,7 +1478,7 @@ static VARIABLE_TYPE term(void)
       {
 
         case TOKENIZER_ASTR:
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+#if defined(UBASIC_HAVE_FLOATS)
           f1 = fixedpt_xmul(f1,f2);
 #else
           f1 = f1 * f2;
@@ -997,7 +1486,7 @@ static VARIABLE_TYPE term(void)
           break;
 
         case TOKENIZER_SLASH:
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+#if defined(UBASIC_HAVE_FLOATS)
           f1 = fixedpt_xdiv(f1,f2);
 #else
           f1 = f1 / f2;
@@ -1005,7 +1494,11 @@ static VARIABLE_TYPE term(void)
           break;
 
         case TOKENIZER_MOD:
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+          f1 = NATIVEFP(fmod)(f1,f2);
+#else
           f1 = f1 % f2;
+#endif
           break;
       }
       op = tokenizer_token();
@@ -1020,7 +1513,7 @@ static VARIABLE_TYPE relation(void)
 
   r1 = (VARIABLE_TYPE) term();
 
-  VARIABLE_TYPE op = tokenizer_token();
+  uint8_t op = tokenizer_token();
 
   while ( op == TOKENIZER_LT || op == TOKENIZER_LE ||
           op == TOKENIZER_GT || op == TOKENIZER_GE ||
@@ -1074,13 +1567,24 @@ static VARIABLE_TYPE relation(void)
         r1 = r1 - r2;
         break;
 
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+      /* native floats have no bits to combine: the raw values are */
+      case TOKENIZER_AND:
+        r1 = nativefp_fromraw(nativefp_toraw(r1) & nativefp_toraw(r2));
+        break;
+
+      case TOKENIZER_OR:
+        r1 = nativefp_fromraw(nativefp_toraw(r1) | nativefp_toraw(r2));
+        break;
+#else
       case TOKENIZER_AND:
-        r1 = ((int32_t) r1) & ((int32_t) r2);
+        r1 = r1 & r2;
         break;
 
       case TOKENIZER_OR:
-        r1 = ((int32_t) r1) | ((int32_t) r2);
+        r1 = r1 | r2;
         break;
+#endif
     }
     op = tokenizer_token();
   }
@@ -1123,13 +1627,13 @@ uint8_t jump_label(char * label)
 
 static void gosub_statement(void)
 {
-  char tmpstring[MAX_STRINGLEN];
+  char tmpstring[MAX_LABEL_LEN];
   accept(TOKENIZER_GOSUB);
 
   if(tokenizer_token() == TOKENIZER_LABEL)
   {
     // copy label
-    tokenizer_label(tmpstring, MAX_STRINGLEN);
+    tokenizer_label(tmpstring, sizeof(tmpstring));
     tokenizer_next();
 
     // check for the end of line
@@ -1173,12 +1677,12 @@ static void return_statement(void)
 
 static void goto_statement(void)
 {
-  char tmpstring[MAX_STRINGLEN];
+  char tmpstring[MAX_LABEL_LEN];
   accept(TOKENIZER_GOTO);
 
   if(tokenizer_token() == TOKENIZER_LABEL)
   {
-    tokenizer_label(tmpstring, sizeof(MAX_STRINGLEN));
+    tokenizer_label(tmpstring, sizeof(tmpstring));
     tokenizer_next();
     jump_label(tmpstring);
     return;
@@ -1202,7 +1706,7 @@ static void pwm_statement(void)
 
   // first argument: channel
   j = relation();
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+#if defined(UBASIC_HAVE_FLOATS)
   j = fixedpt_toint(j);
 #endif
   if (j <1 || j>4)
@@ -1212,7 +1716,7 @@ static void pwm_statement(void)
 
   // second argument: value
   r = relation();
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+#if defined(UBASIC_HAVE_FLOATS)
   r = fixedpt_toint(r);
 #endif
   accept(TOKENIZER_RIGHTPAREN);
@@ -1234,7 +1738,7 @@ static void pwmconf_statement(void)
   accept(TOKENIZER_LEFTPAREN);
   // first argument: prescaler 0...
   j = relation();
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+#if defined(UBASIC_HAVE_FLOATS)
   j = fixedpt_toint(j);
 #endif
   if (j<0)
@@ -1243,7 +1747,7 @@ static void pwmconf_statement(void)
   accept(TOKENIZER_COMMA);
   r = relation();
   // second argument: period
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+#if defined(UBASIC_HAVE_FLOATS)
   r = fixedpt_toint(r);
 #endif
   analogWriteConfig(j,r);
@@ -1264,7 +1768,7 @@ static void areadconf_statement(void)
   accept(TOKENIZER_LEFTPAREN);
   // first argument: sampletime 0...7 on STM32
   j = relation();
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+#if defined(UBASIC_HAVE_FLOATS)
   j = fixedpt_toint(j);
 #endif
   if (j<0)
@@ -1274,7 +1778,7 @@ static void areadconf_statement(void)
   accept(TOKENIZER_COMMA);
   r = relation();
   // second argument: number of analog sample to average from
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+#if defined(UBASIC_HAVE_FLOATS)
   r = fixedpt_toint(r);
 #endif
   analogReadConfig(j,r);
@@ -1292,6 +1796,9 @@ static void pinmode_statement(void)
 
   // channel - should be entered as 0x..
   i = relation();
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+  i = nativefp_toraw(i);
+#endif
   if (i < 0xa0 || i > 0xff)
     return;
 
@@ -1300,7 +1807,7 @@ static void pinmode_statement(void)
   // mode
   j = relation();
 
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+#if defined(UBASIC_HAVE_FLOATS)
   j = fixedpt_toint(j);
 #endif
 
@@ -1313,7 +1820,7 @@ static void pinmode_statement(void)
 
   // speed
   r = relation();
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+#if defined(UBASIC_HAVE_FLOATS)
   r = fixedpt_toint(r);
 #endif
   if (r<0 || r>2)
@@ -1336,6 +1843,9 @@ static void dwrite_statemet(void)
   accept(TOKENIZER_LEFTPAREN);
 
   j = relation();
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+  j = nativefp_toraw(j);
+#endif
 
   accept(TOKENIZER_COMMA);
 
@@ -1346,7 +1856,7 @@ static void dwrite_statemet(void)
   accept(TOKENIZER_RIGHTPAREN);
 
   r = digitalWrite(j,r);
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+#if defined(UBASIC_HAVE_FLOATS)
   r = fixedpt_fromint(r);
 #endif
 
@@ -1361,7 +1871,7 @@ static void dwrite_statemet(void)
 static void print_statement(uint8_t println)
 {
   uint8_t print_how=0; /*0-xp, 1-hex, 2-oct, 3-dec, 4-bin*/
-  char tmpstring[MAX_STRINGLEN];
+  char tmpstring[NUMCONV_MAXLEN];
 
   // string additions
   if (println)
@@ -1382,52 +1892,57 @@ static void print_statement(uint8_t println)
       print_how = 2;
     }
 
-#if defined(VARIABLE_TYPE_STRING)
-    if(tokenizer_token() == TOKENIZER_STRING)
+    if(tokenizer_token() == TOKENIZER_COMMA)
     {
-      tokenizer_string(tmpstring, MAX_STRINGLEN);
+      print_serial(" ");
       tokenizer_next();
     }
-    else
-#endif
-    if(tokenizer_token() == TOKENIZER_COMMA)
+#if defined(VARIABLE_TYPE_STRING)
+    else if (tokenizer_stringlookahead())
     {
-      sprintf(tmpstring, " ");
-      tokenizer_next();
+      // strings, literals included, are printed directly from stringstack
+      print_serial( STRPTR(sexpr()) );
     }
+#endif
     else
     {
-#if defined(VARIABLE_TYPE_STRING)
-      if (tokenizer_stringlookahead())
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+      // hex and dec print the raw value, as fixed points do
+      if (print_how == 1)
       {
-        sprintf(tmpstring, "%s", STRPTR(sexpr()) );
+        numconv_hex(tmpstring, (NUMCONV_UINT) nativefp_toraw(relation()));
+      }
+      else if (print_how == 2)
+      {
+        numconv_dec(tmpstring, nativefp_toraw(relation()));
+      }
+#else
+      if (print_how == 1)
+      {
+        numconv_hex(tmpstring, (NUMCONV_UINT) relation());
+      }
+      else if (print_how == 2)
+      {
+        numconv_dec(tmpstring, relation());
       }
-      else
 #endif
+      else
       {
-        if (print_how == 1)
-        {
-          sprintf(tmpstring, "%lx", (uint32_t) relation());
-        }
-        else if (print_how == 2)
-        {
-          sprintf(tmpstring, "%ld", relation());
-        }
-        else
-        {
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
-          fixedpt_str( relation(), tmpstring, FIXEDPT_FBITS/3 );
+#if defined(UBASIC_HAVE_FIXEDPT_FLOATS)
+        numconv_fixedpt(tmpstring, relation(), FIXEDPT_FBITS/3 );
+#elif defined(VARIABLE_TYPE_FLOAT_NATIVE)
+        numconv_float(tmpstring, relation(), NATIVEFP_DECIMALS);
 #else
-          sprintf(tmpstring, "%ld", relation());
+        numconv_dec(tmpstring, relation());
 #endif
-        }
       }
-    // end of string additions
+      print_serial(tmpstring);
     }
-    print_serial(tmpstring);
+    // end of string additions
   }
   while ( tokenizer_token() != TOKENIZER_EOL &&
-          tokenizer_token() != TOKENIZER_ENDOFINPUT );
+          tokenizer_token() != TOKENIZER_ENDOFINPUT &&
+          !ubasic_status.bit.Error );
 
   // printf("\n");
   if (println)
@@ -1681,6 +2196,20 @@ static void let_statement(void)
   {
     varnum = tokenizer_variable_num();
     accept(TOKENIZER_STRINGVARIABLE);
+#if defined(VARIABLE_TYPE_STRING_ARRAY)
+    if (tokenizer_token() == TOKENIZER_LEFTPAREN)
+    {
+      accept(TOKENIZER_LEFTPAREN);
+      VARIABLE_TYPE idx = relation();
+  #if defined(UBASIC_HAVE_FLOATS)
+      idx = fixedpt_toint( idx );
+  #endif
+      accept(TOKENIZER_RIGHTPAREN);
+      if (!accept(TOKENIZER_EQ))
+        ubasic_set_stringarrayvariable(varnum, (uint16_t) idx, sexpr());
+    }
+    else
+#endif
     if (!accept(TOKENIZER_EQ))
     {
       // print_serial("let_s:");
@@ -1699,24 +2228,20 @@ static void let_statement(void)
     varnum = tokenizer_variable_num();
     accept(TOKENIZER_ARRAYVARIABLE);
 
-    accept(TOKENIZER_LEFTPAREN);
-    VARIABLE_TYPE idx = relation();
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
-    idx = fixedpt_toint( idx );
-  #endif
-    accept(TOKENIZER_RIGHTPAREN);
+    uint16_t idx = array_index(varnum);
     if (!accept(TOKENIZER_EQ))
-      ubasic_set_arrayvariable(varnum, (uint16_t) idx, relation());
+      ubasic_set_arrayvariable(varnum, idx, relation());
   }
 #endif
 
   accept_cr();
 }
 
-#if defined(VARIABLE_TYPE_ARRAY)
+#if defined(VARIABLE_TYPE_ARRAY) || defined(VARIABLE_TYPE_STRING_ARRAY)
 static void dim_statement(void)
 {
-  VARIABLE_TYPE size=0;
+  VARIABLE_TYPE size=0, cols=0;
+  uint8_t token;
 
   accept (TOKENIZER_DIM);
 
@@ -1724,42 +2249,450 @@ static void dim_statement(void)
   uint8_t  varnum = tokenizer_variable_num();
 
 //
-  accept (TOKENIZER_ARRAYVARIABLE);
+  token = tokenizer_token();
+#if defined(VARIABLE_TYPE_ARRAY)
+  if (token != TOKENIZER_ARRAYVARIABLE)
+#endif
+#if defined(VARIABLE_TYPE_STRING_ARRAY)
+  if (token != TOKENIZER_STRINGVARIABLE)
+#endif
+  {
+    tokenizer_error_print(token);
+    ubasic_status.bit.isRunning = 0;
+    ubasic_status.bit.Error = 1;
+    return;
+  }
+  tokenizer_next();
 
-//   accept(TOKENIZER_LEFTPAREN);
+  accept(TOKENIZER_LEFTPAREN);
   size = relation();
-
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+#if defined(UBASIC_HAVE_FLOATS)
   size = fixedpt_toint( size );
 #endif
 
-  ubasic_dim_arrayvariable(varnum, size);
+  // two dimensional: dim a@(rows, cols)
+  if (tokenizer_token() == TOKENIZER_COMMA)
+  {
+    accept(TOKENIZER_COMMA);
+    cols = relation();
+#if defined(UBASIC_HAVE_FLOATS)
+    cols = fixedpt_toint( cols );
+#endif
+  }
+  accept(TOKENIZER_RIGHTPAREN);
+
+  // checked here, before the sizes are narrowed to 16 bits
+  if ( (size < 0) || (size > 0xffff) || (cols < 0) || (cols > 255) )
+  {
+    tokenizer_error_print(TOKENIZER_DIM);
+    ubasic_status.bit.isRunning = 0;
+    ubasic_status.bit.Error = 1;
+    return;
+  }
+
+#if defined(VARIABLE_TYPE_STRING_ARRAY)
+  if (token == TOKENIZER_STRINGVARIABLE)
+  {
+    // string arrays are one dimensional
+    if (cols)
+    {
+      ubasic_status.bit.isRunning = 0;
+      ubasic_status.bit.Error = 1;
+    }
+    else
+      ubasic_dim_stringarrayvariable(varnum, size);
+    if (ubasic_status.bit.Error)
+    {
+      tokenizer_error_print(TOKENIZER_DIM);
+      return;
+    }
+  }
+#endif
+#if defined(VARIABLE_TYPE_ARRAY)
+  if (token == TOKENIZER_ARRAYVARIABLE)
+  {
+    // packed arrays: dim a@(n) as int8|uint8|int16
+    uint8_t type = ARRAY_TYPE_VARIABLE;
+    char tmpstring[MAX_LABEL_LEN];
+    if (tokenizer_token() == TOKENIZER_AS)
+    {
+      accept(TOKENIZER_AS);
+      tokenizer_label(tmpstring, sizeof(tmpstring));
+      accept(TOKENIZER_LABEL);
+      if (strcmp(tmpstring, "int8") == 0)
+        type = ARRAY_TYPE_INT8;
+      else if (strcmp(tmpstring, "uint8") == 0)
+        type = ARRAY_TYPE_UINT8;
+      else if (strcmp(tmpstring, "int16") == 0)
+        type = ARRAY_TYPE_INT16;
+      else
+      {
+        tokenizer_error_print(TOKENIZER_AS);
+        ubasic_status.bit.isRunning = 0;
+        ubasic_status.bit.Error = 1;
+        return;
+      }
+    }
+    // ring arrays: dim r@(n) [as type] ring
+    if (tokenizer_token() == TOKENIZER_RING)
+    {
+      accept(TOKENIZER_RING);
+      type |= ARRAY_TYPE_RING;
+    }
+    if ( (cols) || (type != ARRAY_TYPE_VARIABLE) )
+      ubasic_dim_typedarrayvariable(varnum, size, cols, type);
+    else
+      ubasic_dim_arrayvariable(varnum, size);
+    if (ubasic_status.bit.Error)
+    {
+      tokenizer_error_print(TOKENIZER_DIM);
+      return;
+    }
+  }
+#endif
 
-//   accept(TOKENIZER_RIGHTPAREN);
   accept_cr();
 
 // end of array additions
 }
 #endif
 
+#if defined(VARIABLE_TYPE_STRING)
+#if defined(VARIABLE_TYPE_ARRAY) || defined(VARIABLE_TYPE_STRING_ARRAY)
 /*---------------------------------------------------------------------------*/
-static void next_statement(void)
+// split s$, d$ into a$() or a@(): fields of s$ separated by any of the
+// characters in d$ are stored in the array elements in one pass over s$.
+// Elements past the last field are cleared.
+static void split_statement(void)
 {
-  accept(TOKENIZER_NEXT);
-
-  uint8_t var = tokenizer_variable_num();
+  int16_t s, d;
+  uint16_t i, l, size=0;
+  uint8_t varnum, token;
+  char *p, *e;
 
-  accept(TOKENIZER_VARIABLE);
+  accept(TOKENIZER_SPLIT);
+  s = sexpr();
+  accept(TOKENIZER_COMMA);
+  d = sexpr();
+  accept(TOKENIZER_INTO);
 
-  if(for_stack_ptr > 0 && var == for_stack[for_stack_ptr - 1].for_variable)
+  varnum = tokenizer_variable_num();
+  token = tokenizer_token();
+  tokenizer_next();
+  if (tokenizer_token() == TOKENIZER_LEFTPAREN)
   {
-    VARIABLE_TYPE value = ubasic_get_variable(var) + for_stack[for_stack_ptr - 1].step;
-    ubasic_set_variable(var, value);
+    accept(TOKENIZER_LEFTPAREN);
+    accept(TOKENIZER_RIGHTPAREN);
+  }
 
-    if ( ( (for_stack[for_stack_ptr - 1].step > 0) &&
-            (value <= for_stack[for_stack_ptr - 1].to) ) ||
-         ( (for_stack[for_stack_ptr - 1].step < 0) &&
-            (value >= for_stack[for_stack_ptr - 1].to) ) )
+#if defined(VARIABLE_TYPE_STRING_ARRAY)
+  if ( (token == TOKENIZER_STRINGVARIABLE) && (sarrayvariable[varnum] > -1) )
+    size = sarrays_data[sarrayvariable[varnum]];
+  else
+#endif
+#if defined(VARIABLE_TYPE_ARRAY)
+  if ( (token == TOKENIZER_ARRAYVARIABLE) && (arrayvariable[varnum] > -1) &&
+       !ARRAY_HDR_RING(arrays_data[arrayvariable[varnum]]) )
+    size = ARRAY_HDR_SIZE(arrays_data[arrayvariable[varnum]]);
+  else
+#endif
+  {
+    // not an array, not dimensioned or a ring array, which fills by push
+    tokenizer_error_print(token);
+    ubasic_status.bit.isRunning = 0;
+    ubasic_status.bit.Error = 1;
+    return;
+  }
+
+  p = STRPTR(s);
+  e = p + STRLEN(s);
+  for (i=1; i<=size; i++)
+  {
+    l = 0;
+    if (p <= e)
+      l = strcspn(p, STRPTR(d));
+
+#if defined(VARIABLE_TYPE_STRING_ARRAY)
+    if (token == TOKENIZER_STRINGVARIABLE)
+    {
+      ubasic_set_stringarrayvariable(varnum, i, (l>0) ? scpy_n(p, l) : -1);
+    }
+#endif
+#if defined(VARIABLE_TYPE_ARRAY)
+    if (token == TOKENIZER_ARRAYVARIABLE)
+    {
+      VARIABLE_TYPE r = 0;
+      char tmpstring[NUMCONV_MAXLEN];
+      if (l > 0)
+      {
+        uint8_t n = (l < sizeof(tmpstring)) ? l : sizeof(tmpstring)-1;
+        memcpy(tmpstring, p, n);
+        tmpstring[n] = 0;
+  #if defined(UBASIC_HAVE_FIXEDPT_FLOATS)
+        r = str_fixedpt(tmpstring, n, FIXEDPT_FBITS>>1);
+  #elif defined(VARIABLE_TYPE_FLOAT_NATIVE)
+        r = str_fixedpt(tmpstring, n, NATIVEFP_DIGITS);
+  #else
+        r = ubasic_atoi(tmpstring);
+  #endif
+      }
+      ubasic_set_arrayvariable(varnum, i, r);
+    }
+#endif
+
+    p += l + 1;
+  }
+
+  accept_cr();
+}
+#endif
+#endif
+
+#if defined(VARIABLE_TYPE_ARRAY)
+#if defined(UBASIC_SCRIPT_HAVE_RANDOM_NUMBER_GENERATOR)
+// arand fills with uniform numbers by default, and with ran numbers
+// without floats
+#if defined(UBASIC_HAVE_FLOATS)
+#define ARRAY_RAND_MAX  FIXEDPT_ONE
+#else
+#define ARRAY_RAND_MAX  VARIABLE_TYPE_MAX
+#endif
+#endif
+
+/*---------------------------------------------------------------------------*/
+// afill a@, value
+// ashift a@, n    (towards higher indices for n>0, clearing the vacated ones)
+// arotate a@, n
+// acopy b@, a@ [, src_start, dst_start, count]
+// asort a@ [, desc]
+// push r@, value  (ring arrays)
+// arand a@ [, lo, hi]
+static void arrays_statement(void)
+{
+  uint8_t token = tokenizer_token(), a, b = 0, i;
+  VARIABLE_TYPE r, arg[3] = {1, 1, -1};
+  char label[MAX_LABEL_LEN];
+
+  tokenizer_next();
+  a = array_argument();
+
+  if (token == TOKENIZER_ASORT)
+  {
+    i = 0;
+    if (tokenizer_token() == TOKENIZER_COMMA)
+    {
+      accept(TOKENIZER_COMMA);
+      tokenizer_label(label, sizeof(label));
+      accept(TOKENIZER_LABEL);
+      if (strcmp(label, "desc"))
+      {
+        tokenizer_error_print(token);
+        ubasic_status.bit.isRunning = 0;
+        ubasic_status.bit.Error = 1;
+      }
+      i = 1;
+    }
+    if (!ubasic_status.bit.Error)
+      arrays_sort_all(a, i);
+    accept_cr();
+    return;
+  }
+
+#if defined(UBASIC_SCRIPT_HAVE_RANDOM_NUMBER_GENERATOR)
+  if (token == TOKENIZER_ARAND)
+  {
+    arg[0] = 0;
+    arg[1] = ARRAY_RAND_MAX;
+    if (tokenizer_token() == TOKENIZER_COMMA)
+    {
+      accept(TOKENIZER_COMMA);
+      arg[0] = relation();
+      accept(TOKENIZER_COMMA);
+      arg[1] = relation();
+    }
+    if (!ubasic_status.bit.Error)
+      arrays_rand(a, arg[0], arg[1]);
+    accept_cr();
+    return;
+  }
+#endif
+
+  accept(TOKENIZER_COMMA);
+  if (token == TOKENIZER_ACOPY)
+  {
+    b = array_argument();
+    for (i=0; (i<3) && (tokenizer_token() == TOKENIZER_COMMA); i++)
+    {
+      accept(TOKENIZER_COMMA);
+      arg[i] = relation();
+#if defined(UBASIC_HAVE_FLOATS)
+      arg[i] = fixedpt_toint(arg[i]);
+#endif
+    }
+    if ( !ubasic_status.bit.Error && arrays_copy(a, b, arg) )
+    {
+      tokenizer_error_print(token);
+      ubasic_status.bit.isRunning = 0;
+      ubasic_status.bit.Error = 1;
+    }
+  }
+  else
+  {
+    r = relation();
+    if (!ubasic_status.bit.Error)
+    {
+      if (token == TOKENIZER_AFILL)
+        arrays_fill(a, r);
+      else if (token == TOKENIZER_PUSH)
+        b = arrays_push(a, r);
+      else
+      {
+#if defined(UBASIC_HAVE_FLOATS)
+        r = fixedpt_toint(r);
+#endif
+        b = arrays_shift(a, r, token == TOKENIZER_AROTATE);
+      }
+      if (b)
+      {
+        tokenizer_error_print(token);
+        ubasic_status.bit.isRunning = 0;
+        ubasic_status.bit.Error = 1;
+      }
+    }
+  }
+
+  accept_cr();
+}
+
+/*---------------------------------------------------------------------------*/
+// filter_init f@, c@ [, biquad]
+static void filter_init_statement(void)
+{
+  uint8_t f, c, biquad = 0;
+  char label[MAX_LABEL_LEN];
+
+  accept(TOKENIZER_FILTER_INIT);
+  f = array_target();
+  accept(TOKENIZER_COMMA);
+  c = array_argument();
+
+  if (tokenizer_token() == TOKENIZER_COMMA)
+  {
+    accept(TOKENIZER_COMMA);
+    tokenizer_label(label, sizeof(label));
+    accept(TOKENIZER_LABEL);
+    if (strcmp(label, "biquad"))
+    {
+      tokenizer_error_print(TOKENIZER_FILTER_INIT);
+      ubasic_status.bit.isRunning = 0;
+      ubasic_status.bit.Error = 1;
+    }
+    biquad = 1;
+  }
+
+  if ( !ubasic_status.bit.Error && arrays_filter_init(f, c, biquad) )
+  {
+    tokenizer_error_print(TOKENIZER_FILTER_INIT);
+    ubasic_status.bit.isRunning = 0;
+    ubasic_status.bit.Error = 1;
+  }
+  accept_cr();
+}
+
+/*---------------------------------------------------------------------------*/
+// matmul c@, a@, b@     c = a b
+// mattrans b@, a@       b = a transposed, b may be a if it is square
+// matvec y@, a@, x@     y = a x
+static void matrix_statement(void)
+{
+  uint8_t token = tokenizer_token(), a, b, c = 0;
+
+  tokenizer_next();
+  a = array_target();
+  accept(TOKENIZER_COMMA);
+  b = array_argument();
+  if (token != TOKENIZER_MATTRANS)
+  {
+    accept(TOKENIZER_COMMA);
+    c = array_argument();
+  }
+
+  if ( !ubasic_status.bit.Error && arrays_matrix(token, a, b, c) )
+  {
+    tokenizer_error_print(token);
+    ubasic_status.bit.isRunning = 0;
+    ubasic_status.bit.Error = 1;
+  }
+  accept_cr();
+}
+
+#if defined(UBASIC_SCRIPT_HAVE_FFT)
+/*---------------------------------------------------------------------------*/
+// fft re@, im@ [, inverse]
+// amag m@, re@, im@
+static void fft_statement(void)
+{
+  uint8_t token = tokenizer_token(), a, b, m = 0, inverse = 0;
+  char label[MAX_LABEL_LEN];
+
+  tokenizer_next();
+  if (token == TOKENIZER_AMAG)
+  {
+    m = array_argument();
+    accept(TOKENIZER_COMMA);
+  }
+  a = array_argument();
+  accept(TOKENIZER_COMMA);
+  b = array_argument();
+
+  if ( (token == TOKENIZER_FFT) && (tokenizer_token() == TOKENIZER_COMMA) )
+  {
+    accept(TOKENIZER_COMMA);
+    tokenizer_label(label, sizeof(label));
+    accept(TOKENIZER_LABEL);
+    if (strcmp(label, "inverse"))
+    {
+      tokenizer_error_print(token);
+      ubasic_status.bit.isRunning = 0;
+      ubasic_status.bit.Error = 1;
+    }
+    inverse = 1;
+  }
+
+  if (!ubasic_status.bit.Error)
+  {
+    if (token == TOKENIZER_AMAG)
+      arrays_mag(m, a, b);
+    else if (arrays_fft(a, b, inverse))
+    {
+      tokenizer_error_print(token);
+      ubasic_status.bit.isRunning = 0;
+      ubasic_status.bit.Error = 1;
+    }
+  }
+  accept_cr();
+}
+#endif
+#endif
+
+/*---------------------------------------------------------------------------*/
+static void next_statement(void)
+{
+  accept(TOKENIZER_NEXT);
+
+  uint8_t var = tokenizer_variable_num();
+
+  accept(TOKENIZER_VARIABLE);
+
+  if(for_stack_ptr > 0 && var == for_stack[for_stack_ptr - 1].for_variable)
+  {
+    VARIABLE_TYPE value = ubasic_get_variable(var) + for_stack[for_stack_ptr - 1].step;
+    ubasic_set_variable(var, value);
+
+    if ( ( (for_stack[for_stack_ptr - 1].step > 0) &&
+            (value <= for_stack[for_stack_ptr - 1].to) ) ||
+         ( (for_stack[for_stack_ptr - 1].step < 0) &&
+            (value >= for_stack[for_stack_ptr - 1].to) ) )
     {
       //jump_line(for_stack[for_stack_ptr - 1].line_after_for);
       tokenizer_jump_offset(for_stack[for_stack_ptr - 1].line_after_for);
@@ -1792,7 +2725,7 @@ static void for_statement(void)
   accept(TOKENIZER_TO);
   to = relation();
 
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+#if defined(UBASIC_HAVE_FLOATS)
   VARIABLE_TYPE step = FIXEDPT_ONE;
 #else
   VARIABLE_TYPE step = 1;
@@ -1836,7 +2769,7 @@ static void sleep_statement(void)
   VARIABLE_TYPE f = relation();
   if (f > 0)
   {
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+#if defined(UBASIC_HAVE_FLOATS)
     ubasic_script_sleeping_ms = fixedpt_toint(f * 1000);
 #else
     ubasic_script_sleeping_ms = (uint32_t) f;
@@ -1857,7 +2790,7 @@ static void tic_statement(void)
   accept(TOKENIZER_LEFTPAREN);
 
   VARIABLE_TYPE f = relation();
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+  #if defined(UBASIC_HAVE_FLOATS)
     f = fixedpt_toint(f);
   #endif
 
@@ -1909,6 +2842,18 @@ static void input_statement_wait (void)
     input_varnum = tokenizer_variable_num();
     accept(TOKENIZER_STRINGVARIABLE);
     input_type = 1;
+    #if defined(VARIABLE_TYPE_STRING_ARRAY)
+    if (tokenizer_token() == TOKENIZER_LEFTPAREN)
+    {
+      accept(TOKENIZER_LEFTPAREN);
+      input_array_index = relation();
+      #if defined(UBASIC_HAVE_FLOATS)
+      input_array_index = fixedpt_toint( input_array_index );
+      #endif
+      accept(TOKENIZER_RIGHTPAREN);
+      input_type = 3;
+    }
+    #endif
   }
   // end of string additions
   #endif
@@ -1918,12 +2863,7 @@ static void input_statement_wait (void)
     input_varnum = tokenizer_variable_num();
     accept(TOKENIZER_ARRAYVARIABLE);
 
-    accept(TOKENIZER_LEFTPAREN);
-    input_array_index = relation();
-    #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
-    input_array_index = fixedpt_toint( input_array_index );
-    #endif
-    accept(TOKENIZER_RIGHTPAREN);
+    input_array_index = array_index(input_varnum);
     input_type = 2;
   }
   #endif
@@ -1936,7 +2876,7 @@ static void input_statement_wait (void)
   {
     accept(TOKENIZER_COMMA);
     VARIABLE_TYPE r = relation();
-  #if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
+  #if defined(UBASIC_HAVE_FLOATS)
     r = fixedpt_toint( r );
   #endif
     if (r>0)
@@ -1952,12 +2892,41 @@ static void input_statement_wait (void)
 
 static void serial_input_completed(void)
 {
-  char tmpstring[MAX_STRINGLEN];
+  char tmpstring[NUMCONV_MAXLEN];
 
   // transfer serial input buffer to 'buf' only if something
   // has been received.
   // otherwise leave the variable content unchanged.
-  if (serial_input(tmpstring,MAX_STRINGLEN)>0)
+  #if defined(VARIABLE_TYPE_STRING)
+  if (input_type == 1)
+  {
+    // strings are received directly at the end of stringstack
+    // nothing is read while there is no room for a single character
+    if (!string_space_check(0) && string_space_left())
+    {
+      uint16_t l = serial_input(STRPTR(freebufptr), string_space_left());
+      if (l>0)
+      {
+        ubasic_set_stringvariable(input_varnum, sfinish(l));
+      }
+    }
+  }
+  #if defined(VARIABLE_TYPE_STRING_ARRAY)
+  else if (input_type == 3)
+  {
+    if (!string_space_check(0) && string_space_left())
+    {
+      uint16_t l = serial_input(STRPTR(freebufptr), string_space_left());
+      if (l>0)
+      {
+        ubasic_set_stringarrayvariable(input_varnum, input_array_index, sfinish(l));
+      }
+    }
+  }
+  #endif
+  else
+  #endif
+  if (serial_input(tmpstring,sizeof(tmpstring)-1)>0)
   {
     if ( (input_type == 0)
   #if defined(VARIABLE_TYPE_ARRAY)
@@ -1968,15 +2937,17 @@ static void serial_input_completed(void)
       VARIABLE_TYPE r;
       if ((input_how == 1)||(input_how == 2))
       {
-        r = atoi(tmpstring);
+        r = ubasic_atoi(tmpstring);
       }
       else
       {
       // process number
-#if defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_24_8) || defined(VARIABLE_TYPE_FLOAT_AS_FIXEDPT_22_10)
-        r = str_fixedpt(tmpstring,MAX_STRINGLEN,FIXEDPT_FBITS>>1);
+#if defined(UBASIC_HAVE_FIXEDPT_FLOATS)
+        r = str_fixedpt(tmpstring,sizeof(tmpstring),FIXEDPT_FBITS>>1);
+#elif defined(VARIABLE_TYPE_FLOAT_NATIVE)
+        r = str_fixedpt(tmpstring,sizeof(tmpstring),NATIVEFP_DIGITS);
 #else
-        r = atoi(tmpstring);
+        r = ubasic_atoi(tmpstring);
 #endif
       }
 
@@ -1991,12 +2962,6 @@ static void serial_input_completed(void)
       }
   #endif
     }
-  #if defined(VARIABLE_TYPE_STRING)
-    else if (input_type == 1)
-    {
-      ubasic_set_stringvariable(input_varnum, scpy(tmpstring));
-    }
-  #endif
   }
 
   ubasic_status.bit.WaitForSerialInput = 0;
@@ -2103,6 +3068,7 @@ static void endwhile_statement(void)
 static VARIABLE_TYPE recall_statement(void)
 {
   VARIABLE_TYPE rval=0;
+  uint8_t len=0; // bytes read, not stored in rval so it need not be an integer
 
   static uint8_t varnum;
 
@@ -2113,17 +3079,18 @@ static VARIABLE_TYPE recall_statement(void)
   {
     varnum = tokenizer_variable_num();
     accept(TOKENIZER_VARIABLE);
-    EE_ReadVariable( varnum, 0, (uint8_t *) &variables[varnum], (uint8_t *) &rval );
-    rval >>= 2;
+    EE_ReadVariable( varnum, 0, (uint8_t *) &variables[varnum], &len );
+    rval = len / sizeof(VARIABLE_TYPE);
   }
 #if defined(VARIABLE_TYPE_STRING)
   else if (tokenizer_token() == TOKENIZER_STRINGVARIABLE)
   {
     varnum = tokenizer_variable_num();
     accept(TOKENIZER_STRINGVARIABLE);
-    char dummy_s[MAX_STRINGLEN] = {0};
-    EE_ReadVariable( varnum, 1, (uint8_t *) dummy_s, (uint8_t *) &rval );
-    if (rval > 0)
+    char dummy_s[MAX_FLASH_STRINGLEN+2] = {0};
+    EE_ReadVariable( varnum, 1, (uint8_t *) dummy_s, &len );
+    rval = len;
+    if (len > 0)
     {
       ubasic_set_stringvariable(varnum, scpy((char *)dummy_s));
     }
@@ -2136,14 +3103,31 @@ static VARIABLE_TYPE recall_statement(void)
   {
     varnum = tokenizer_variable_num();
     accept(TOKENIZER_ARRAYVARIABLE);
-    VARIABLE_TYPE dummy_a[VARIABLE_TYPE_ARRAY+1];
-    EE_ReadVariable(varnum, 2, (uint8_t *) dummy_a, (uint8_t *) &rval );
-    if (rval > 0)
+    array_entry_t dummy_a[VARIABLE_TYPE_ARRAY+1];
+    EE_ReadVariable(varnum, 2, (uint8_t *) dummy_a, &len );
+    if (len > 0)
+    {
+      len /= sizeof(VARIABLE_TYPE);
+      rval = len;
+      ubasic_dim_arrayvariable(varnum, len);
+      for (uint8_t i=0; i<len; i++)
+        ubasic_set_arrayvariable(varnum, i+1,  dummy_a[i].v);
+    }
+    else
     {
-      rval >>= 2;
-      ubasic_dim_arrayvariable(varnum, rval);
-      for (uint8_t i=0; i<rval; i++)
-        ubasic_set_arrayvariable(varnum, i+1,  dummy_a[i]);
+      // two dimensional or packed array: header first
+      EE_ReadVariable(varnum, 3, (uint8_t *) dummy_a, &len );
+      if (len > 0)
+      {
+        uint16_t n = ARRAY_HDR_SIZE(dummy_a[0]);
+        uint8_t cols = ARRAY_HDR_COLS(dummy_a[0]);
+        ubasic_dim_typedarrayvariable(varnum, (cols) ? n / cols : n, cols,
+                                      ARRAY_HDR_KIND(dummy_a[0]));
+        if ( (arrayvariable[varnum] > -1) &&
+             ((int16_t) (len / sizeof(VARIABLE_TYPE)) == ARRAY_HDR_WORDS(dummy_a[0]) + 1) )
+          memcpy(&arrays_data[arrayvariable[varnum] + 1], &dummy_a[1], len - sizeof(VARIABLE_TYPE));
+        rval = n;
+      }
     }
   }
 #endif
@@ -2163,7 +3147,7 @@ static void store_statement(void)
   {
     varnum = tokenizer_variable_num();
     accept(TOKENIZER_VARIABLE);
-    EE_WriteVariable( varnum, 0, 4, (uint8_t *) &variables[varnum] );
+    EE_WriteVariable( varnum, 0, sizeof(VARIABLE_TYPE), (uint8_t *) &variables[varnum] );
   }
   #if defined(VARIABLE_TYPE_STRING)
   // string additions here
@@ -2171,8 +3155,10 @@ static void store_statement(void)
   {
     varnum = tokenizer_variable_num();
     accept(TOKENIZER_STRINGVARIABLE);
-    EE_WriteVariable( varnum, 1, strlen(STRPTR(stringvariables[varnum])),
-                      (uint8_t *) STRPTR(stringvariables[varnum]) );
+    uint16_t l = STRLEN(stringvariables[varnum]);
+    if (l > MAX_FLASH_STRINGLEN)
+      l = MAX_FLASH_STRINGLEN;
+    EE_WriteVariable( varnum, 1, l, (uint8_t *) STRPTR(stringvariables[varnum]) );
   }
   // end of string additions
   #endif
@@ -2181,8 +3167,35 @@ static void store_statement(void)
   {
     varnum = tokenizer_variable_num();
     accept(TOKENIZER_ARRAYVARIABLE);
-    EE_WriteVariable(varnum, 2, 4 * (arrays_data[arrayvariable[varnum]] & 0x0000ffff),
-                     (uint8_t *) &arrays_data[arrayvariable[varnum] + 1] );
+    int16_t p = arrayvariable[varnum];
+    if (p > -1)
+    {
+      uint16_t l;
+      if (ARRAY_HDR_COLS(arrays_data[p]) || ARRAY_HDR_KIND(arrays_data[p]))
+        l = sizeof(VARIABLE_TYPE) * (ARRAY_HDR_WORDS(arrays_data[p]) + 1);
+      else
+        l = sizeof(VARIABLE_TYPE) * ARRAY_HDR_SIZE(arrays_data[p]);
+
+      // a FLASH record holds at most 255 bytes
+      if (l > 255)
+      {
+        tokenizer_error_print(TOKENIZER_STORE);
+        ubasic_status.bit.isRunning = 0;
+        ubasic_status.bit.Error = 1;
+        return;
+      }
+
+      if (ARRAY_HDR_COLS(arrays_data[p]) || ARRAY_HDR_KIND(arrays_data[p]))
+      {
+        // two dimensional, packed and ring arrays are stored together
+        // with their header
+        EE_WriteVariable(varnum, 3, l, (uint8_t *) &arrays_data[p] );
+      }
+      else
+      {
+        EE_WriteVariable(varnum, 2, l, (uint8_t *) &arrays_data[p + 1] );
+      }
+    }
   }
   #endif
 
@@ -2196,7 +3209,7 @@ static void store_statement(void)
 /*---------------------------------------------------------------------------*/
 static void statement(void)
 {
-  VARIABLE_TYPE token = tokenizer_token();
+  uint8_t token = tokenizer_token();
   uint8_t println=0;
 
   if (ubasic_status.bit.Error)
@@ -2285,10 +3298,42 @@ static void statement(void)
       break;
 #endif
 
-#if defined(VARIABLE_TYPE_ARRAY)
+#if defined(VARIABLE_TYPE_ARRAY) || defined(VARIABLE_TYPE_STRING_ARRAY)
     case TOKENIZER_DIM:
       dim_statement();
       break;
+#if defined(VARIABLE_TYPE_ARRAY)
+    case TOKENIZER_AFILL:
+    case TOKENIZER_ACOPY:
+    case TOKENIZER_ASHIFT:
+    case TOKENIZER_AROTATE:
+    case TOKENIZER_ASORT:
+    case TOKENIZER_PUSH:
+#if defined(UBASIC_SCRIPT_HAVE_RANDOM_NUMBER_GENERATOR)
+    case TOKENIZER_ARAND:
+#endif
+      arrays_statement();
+      break;
+    case TOKENIZER_FILTER_INIT:
+      filter_init_statement();
+      break;
+    case TOKENIZER_MATMUL:
+    case TOKENIZER_MATTRANS:
+    case TOKENIZER_MATVEC:
+      matrix_statement();
+      break;
+#if defined(UBASIC_SCRIPT_HAVE_FFT)
+    case TOKENIZER_FFT:
+    case TOKENIZER_AMAG:
+      fft_statement();
+      break;
+#endif
+#endif
+#if defined(VARIABLE_TYPE_STRING)
+    case TOKENIZER_SPLIT:
+      split_statement();
+      break;
+#endif
 #endif
 
 #if defined(UBASIC_SCRIPT_HAVE_TICTOC)
@@ -2482,18 +3527,36 @@ VARIABLE_TYPE ubasic_get_variable(uint8_t varnum)
 //
 // string additions
 //
+/*---------------------------------------------------------------------------*/
+// point the reference *dest (a variable or an array element) to svalue
+static void sassign(int16_t *dest, int16_t svalue)
+{
+  if (*dest == svalue)
+    return;
+
+  // share the string unless it has run out of references
+  if ( (svalue > -1) && (STRREF(svalue) == STRREF_MAX) )
+    svalue = scpy_n(STRPTR(svalue), STRLEN(svalue));
+
+  if (svalue > -1)
+    STRREF(svalue)++;
+
+  // release previously assigned string, garbage if nobody else uses it
+  if (*dest > -1)
+  {
+    if (--STRREF(*dest) == 0)
+      ubasic_status.bit.stringstackModified = 1;
+  }
+
+  *dest = svalue;
+}
+
 /*---------------------------------------------------------------------------*/
 void ubasic_set_stringvariable(uint8_t svarnum, int16_t svalue)
 {
   if(svarnum < MAX_SVARNUM)
   {
-    // was it previously allocated?
-    if (stringvariables[svarnum] > -1)
-      *(stringstack + stringvariables[svarnum]) = 0;
-
-    stringvariables[svarnum] = svalue;
-    if (svalue > -1)
-      *(stringstack + svalue) = svarnum + 1;
+    sassign(&stringvariables[svarnum], svalue);
 
     // print_serial("set_stringvar:");
     // char msg[12];
@@ -2523,115 +3586,1594 @@ int16_t ubasic_get_stringvariable(uint8_t varnum)
 
   return (-1);
 }
-//
-// end of string additions
-//
-#endif
 
-#if defined(VARIABLE_TYPE_ARRAY)
+#if defined(VARIABLE_TYPE_STRING_ARRAY)
 //
-// array additions: works only for VARIABLE_TYPE 32bit
-//  array storage:
-//    1st entry:   [ 31:16 , 15:0]
-//                  varnum   size
-//    entries 2 through size+1 are the array elements
-//  could work for 16bit values as well
+// string arrays:
+//  sarrays_data holds for each array its size followed by size offsets
+//  into stringstack, -1 for empty strings. Elements hold references to
+//  the strings just like the string variables do.
 /*---------------------------------------------------------------------------*/
-void ubasic_dim_arrayvariable(uint8_t varnum, int16_t newsize)
+void ubasic_dim_stringarrayvariable(uint8_t svarnum, int16_t newsize)
 {
-  if(varnum >= MAX_VARNUM)
-    return;
+  int16_t i, loc, oldlen;
 
-  int16_t oldsize;
-  int16_t  current_location;
-
-_attach_at_the_end:
+  if (svarnum >= MAX_SVARNUM)
+    return;
 
-  current_location = arrayvariable[varnum];
-  if (current_location == -1)
+  if (newsize < 0)
   {
-    /* does the array fit in the available memory? */
-    if (free_arrayptr+newsize+1 < VARIABLE_TYPE_ARRAY)
-    {
-      current_location = free_arrayptr;
-      arrayvariable[varnum] = current_location;
-      arrays_data[current_location] = (varnum<<16) | newsize;
-      free_arrayptr += newsize + 1;
+    ubasic_status.bit.isRunning = 0;
+    ubasic_status.bit.Error = 1;
+    return;
+  }
+
+  loc = sarrayvariable[svarnum];
+  if (loc > -1)
+  {
+    /* if size of the array is the same as earlier allocated then do nothing */
+    if (sarrays_data[loc] == newsize)
       return;
+
+    /* release the strings and shift the arrays above it down */
+    oldlen = sarrays_data[loc] + 1;
+    for (i=1; i<oldlen; i++)
+      sassign(&sarrays_data[loc+i], -1);
+
+    memmove(sarrays_data+loc, sarrays_data+loc+oldlen,
+            (free_sarrayptr-loc-oldlen) * sizeof(int16_t));
+    free_sarrayptr -= oldlen;
+
+    sarrayvariable[svarnum] = -1;
+    for (i=0; i<MAX_SVARNUM; i++)
+    {
+      if (sarrayvariable[i] > loc)
+        sarrayvariable[i] -= oldlen;
     }
-    return; /* failed to allocate*/
   }
-  else
+
+  /* does the array fit in the available memory? */
+  if (free_sarrayptr + newsize + 1 > VARIABLE_TYPE_STRING_ARRAY)
   {
-    oldsize = arrays_data[current_location];
+    ubasic_status.bit.isRunning = 0;
+    ubasic_status.bit.Error = 1;
+    return;
   }
 
-  /* if size of the array is the same as earlier allocated then do nothing */
-  if (oldsize == newsize)
-  {
+  loc = free_sarrayptr;
+  sarrays_data[loc] = newsize;
+  for (i=1; i<=newsize; i++)
+    sarrays_data[loc+i] = -1;
+  sarrayvariable[svarnum] = loc;
+  free_sarrayptr += newsize + 1;
+}
+
+/*---------------------------------------------------------------------------*/
+void ubasic_set_stringarrayvariable(uint8_t svarnum, uint16_t idx, int16_t svalue)
+{
+  if (svarnum >= MAX_SVARNUM)
+    return;
+
+  int16_t loc = sarrayvariable[svarnum];
+  if ( (loc < 0) || (idx < 1) || (idx > sarrays_data[loc]) )
     return;
+
+  sassign(&sarrays_data[loc + idx], svalue);
+}
+
+/*---------------------------------------------------------------------------*/
+int16_t ubasic_get_stringarrayvariable(uint8_t svarnum, uint16_t idx)
+{
+  if (svarnum >= MAX_SVARNUM)
+    return (-1);
+
+  int16_t loc = sarrayvariable[svarnum];
+  if ( (loc < 0) || (idx < 1) || (idx > sarrays_data[loc]) )
+    return (-1);
+
+  return sarrays_data[loc + idx];
+}
+#endif
+//
+// end of string additions
+//
+#endif
+
+#if defined(VARIABLE_TYPE_ARRAY)
+//
+// array additions: for every VARIABLE_TYPE, 32 or 64 bit, integer, fixed
+// point or native float: an entry (array_entry_t) is a value or the bits
+// of an integer, and headers are 32 bit patterns kept in the integer
+// through ARRAY_BITS and ARRAY_WORD
+//  array storage is a heap of blocks, each block starting with a header
+//    1st entry:   [ 31:24 , 23 , 22:21 , 20:16 , 15:0]
+//                   cols   ring   type   varnum   size
+//    the following entries hold the size array elements
+//  cols is 0 for one dimensional arrays, while rows x cols arrays are
+//  stored row by row. varnum is ARRAY_FREE for free blocks.
+//  type is ARRAY_TYPE_VARIABLE for arrays of VARIABLE_TYPE, one element per
+//  entry, while packed arrays keep 8 or 16 bit integers several to an entry
+//  (arrays_words), so the size of a block is not always its number of
+//  elements.
+//  Ring arrays have one more entry ahead of the elements, with the number
+//  of elements pushed so far (up to size) and the place of the next one.
+//  Their elements are indexed from the newest one, see arrays_raw().
+//  arrayvariable[] is the handle table pointing to the header of each
+//  allocated array, so that arrays can be resized without moving the
+//  others:
+//    - shrinking an array returns its tail to the heap,
+//    - growing an array takes over the free block following it if that
+//      is large enough, otherwise the array alone is moved to the
+//      smallest free block that fits (best fit).
+//  Adjacent free blocks are always merged. Only if no free block is large
+//  enough all arrays are slid together (arrays_compact).
+/*---------------------------------------------------------------------------*/
+static void arrays_init(void)
+{
+  arrays_data[0] = ARRAY_HDR(ARRAY_FREE, VARIABLE_TYPE_ARRAY-1);
+}
+
+/*---------------------------------------------------------------------------*/
+// merge adjacent free blocks
+static void arrays_coalesce(void)
+{
+  int16_t p=0, q;
+
+  while (p < VARIABLE_TYPE_ARRAY)
+  {
+    q = ARRAY_NEXT(p);
+    if ( ARRAY_IS_FREE(p) && (q < VARIABLE_TYPE_ARRAY) && ARRAY_IS_FREE(q) )
+    {
+      arrays_data[p] = ARRAY_HDR(ARRAY_FREE, q - p + ARRAY_HDR_SIZE(arrays_data[q]));
+      continue;
+    }
+    p = q;
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+// assign n entries of the block at p to the array varnum and return the
+// rest of the block to the heap
+static void arrays_take(int16_t p, uint8_t varnum, uint16_t n)
+{
+  uint16_t size = ARRAY_HDR_SIZE(arrays_data[p]);
+
+  arrays_data[p] = ARRAY_HDR(varnum, n);
+  if (size > n)
+  {
+    arrays_data[p+n+1] = ARRAY_HDR(ARRAY_FREE, size-n-1);
+    arrays_coalesce();
   }
+}
 
-  /* if this is the last array in arrays_data, just modify the boundary */
-  if (current_location + oldsize + 1 == free_arrayptr)
+/*---------------------------------------------------------------------------*/
+// the smallest free block that holds n entries, -1 if there is none
+static int16_t arrays_bestfit(uint16_t n)
+{
+  int16_t p, best=-1;
+  uint16_t size;
+
+  for (p=0; p<VARIABLE_TYPE_ARRAY; p=ARRAY_NEXT(p))
   {
-    if (free_arrayptr - current_location + newsize < VARIABLE_TYPE_ARRAY)
+    size = ARRAY_HDR_SIZE(arrays_data[p]);
+    if ( ARRAY_IS_FREE(p) && (size >= n) )
     {
-      arrays_data[current_location] = (varnum<<16) | newsize;
-      free_arrayptr += newsize - oldsize;
-      arrays_data[free_arrayptr] = 0;
-      return;
+      if ( (best < 0) || (size < ARRAY_HDR_SIZE(arrays_data[best])) )
+        best = p;
     }
+  }
+  return best;
+}
+
+/*---------------------------------------------------------------------------*/
+static void arrays_reverse(int16_t from, int16_t to)
+{
+  array_entry_t t;
+  while (from < --to)
+  {
+    t = arrays_data[from];
+    arrays_data[from++] = arrays_data[to];
+    arrays_data[to] = t;
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+// last resort if the free space is too fragmented: slide all arrays down
+// so that a single free block is left at the end. The array 'last', if it
+// is not MAX_VARNUM, is rotated to be the last one, just before the free
+// block.
+static void arrays_compact(uint8_t last)
+{
+  int16_t p, q=0;
+  uint16_t n;
+
+  for (p=0; p<VARIABLE_TYPE_ARRAY; p+=n+1)
+  {
+    n = ARRAY_HDR_WORDS(arrays_data[p]);
+    if (!ARRAY_IS_FREE(p))
+    {
+      if (q != p)
+      {
+        memmove(&arrays_data[q], &arrays_data[p], (n+1) * sizeof(VARIABLE_TYPE));
+        arrayvariable[ARRAY_HDR_VARNUM(arrays_data[q])] = q;
+      }
+      q += n+1;
+    }
+  }
+
+  if ( (last < MAX_VARNUM) && (arrayvariable[last] > -1) )
+  {
+    p = arrayvariable[last];
+    n = ARRAY_HDR_WORDS(arrays_data[p]) + 1;
+    arrays_reverse(p, p+n);
+    arrays_reverse(p+n, q);
+    arrays_reverse(p, q);
+    for ( ; p<q; p=ARRAY_NEXT(p))
+      arrayvariable[ARRAY_HDR_VARNUM(arrays_data[p])] = p;
+  }
+
+  if (q < VARIABLE_TYPE_ARRAY)
+    arrays_data[q] = ARRAY_HDR(ARRAY_FREE, VARIABLE_TYPE_ARRAY-q-1);
+}
+
+/*---------------------------------------------------------------------------*/
+// resize the array at p without moving it, growing into the free block
+// that follows: returns 0 if there is not enough room
+static uint8_t arrays_resize(int16_t p, uint8_t varnum, uint16_t newsize)
+{
+  uint16_t i, room, oldsize;
+  int16_t q = ARRAY_NEXT(p);
+
+  room = oldsize = ARRAY_HDR_WORDS(arrays_data[p]);
+  if ( (q < VARIABLE_TYPE_ARRAY) && ARRAY_IS_FREE(q) )
+    room += ARRAY_HDR_SIZE(arrays_data[q]) + 1;
+  if (room < newsize)
+    return 0;
+
+  arrays_data[p] = ARRAY_HDR(varnum, room);
+  for (i=oldsize+1; i<=newsize; i++)
+    arrays_data[p+i].w = 0;
+  arrays_take(p, varnum, newsize);
+  return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+// give the array varnum newsize entries, keeping its contents: returns 0 if
+// there is not enough memory. The header is left for the caller to set.
+static uint8_t arrays_alloc(uint8_t varnum, uint16_t newsize)
+{
+  int16_t  p, q;
+  uint16_t oldsize = 0, i;
+
+  p = arrayvariable[varnum];
+  if (p > -1)
+  {
+    oldsize = ARRAY_HDR_WORDS(arrays_data[p]);
+
+    if (oldsize == newsize)
+      return 1;
+
+    if (arrays_resize(p, varnum, newsize))
+      return 1;
+  }
+
+  q = arrays_bestfit(newsize);
+  if (q < 0)
+  {
+    arrays_compact(varnum);
+    if (p > -1)
+    {
+      /* the free space now follows the array */
+      if (arrays_resize(arrayvariable[varnum], varnum, newsize))
+        return 1;
+    }
+    else
+    {
+      q = arrays_bestfit(newsize);
+    }
+  }
 
+  if (q < 0)
+  {
     /* failed to allocate memory */
+    ubasic_status.bit.isRunning = 0;
+    ubasic_status.bit.Error = 1;
+    return 0;
+  }
+
+  /* only this array is moved */
+  if (p > -1)
+    memcpy(&arrays_data[q+1], &arrays_data[p+1], oldsize * sizeof(VARIABLE_TYPE));
+  for (i=oldsize+1; i<=newsize; i++)
+    arrays_data[q+i].w = 0;
+  arrays_take(q, varnum, newsize);
+  arrayvariable[varnum] = q;
+
+  if (p > -1)
+  {
+    arrays_data[p] = ARRAY_HDR(ARRAY_FREE, oldsize);
+    arrays_coalesce();
+  }
+  return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+// entries taken by n elements of the given type
+static uint16_t arrays_words(uint16_t n, uint8_t type)
+{
+  switch (type)
+  {
+    case ARRAY_TYPE_INT8:
+    case ARRAY_TYPE_UINT8:
+      return (n + sizeof(VARIABLE_TYPE) - 1) / sizeof(VARIABLE_TYPE);
+
+    case ARRAY_TYPE_INT16:
+      return (2 * (uint32_t) n + sizeof(VARIABLE_TYPE) - 1) / sizeof(VARIABLE_TYPE);
+  }
+  return n;
+}
+
+/*---------------------------------------------------------------------------*/
+// rows x cols array of the given element type, cols is 0 for one
+// dimensional arrays. The elements are kept row by row, so that the whole
+// array is also accessible as one dimensional array of size rows*cols.
+// Redimensioning keeps the elements, unless the type changes: then the
+// array starts out cleared. Ring arrays (type with ARRAY_TYPE_RING) are one
+// dimensional and start out empty whenever they are dimensioned.
+void ubasic_dim_typedarrayvariable(uint8_t varnum, uint16_t rows, uint16_t cols, uint8_t type)
+{
+  int16_t  p;
+  uint16_t words;
+  uint32_t n, i;
+  uint8_t  ring = (type & ARRAY_TYPE_RING) ? 1 : 0;
+
+  n = (cols) ? (uint32_t) rows * cols : (uint32_t) rows;
+  if ( (varnum >= MAX_VARNUM) || (cols > 255) ||
+       (type > (ARRAY_TYPE_RING | ARRAY_TYPE_INT16)) || (ring && cols) || (n > 0xffff) ||
+       (arrays_words(n, type & 0x03) + ring >= VARIABLE_TYPE_ARRAY) )
+  {
+    ubasic_status.bit.isRunning = 0;
+    ubasic_status.bit.Error = 1;
+    return;
+  }
+
+  p = arrayvariable[varnum];
+  if ( (p > -1) && (ARRAY_HDR_KIND(arrays_data[p]) != type) )
+  {
+    arrays_data[p] = ARRAY_HDR(ARRAY_FREE, ARRAY_HDR_WORDS(arrays_data[p]));
+    arrays_coalesce();
     arrayvariable[varnum] = -1;
+  }
+
+  words = arrays_words(n, type & 0x03);
+  if (!arrays_alloc(varnum, words + ring))
     return;
+
+  p = arrayvariable[varnum];
+  arrays_data[p] = ARRAY_HDR_FULL(varnum, n, cols, type);
+  if (ring)
+    arrays_data[p+1] = RING_STATE(0, 0);
+
+  /* keep the unused bytes of the last entry cleared for when the array
+     grows again */
+  if ((type & 0x03) != ARRAY_TYPE_VARIABLE)
+  {
+    uint8_t *d = (uint8_t *) &arrays_data[ARRAY_DATA(p)];
+    for (i = ((type & 0x03) == ARRAY_TYPE_INT16) ? 2*n : n; i < words * sizeof(VARIABLE_TYPE); i++)
+      d[i] = 0;
   }
+}
 
-  /* Array has been allocated before. It is not the last array */
-  /* Thus we have to go over all arrays above the current location, and shift them down */
-  arrayvariable[varnum] = -1;
-  int16_t  next_location;
-  uint16_t mov_size, mov_varnum;
-  next_location = current_location + oldsize + 1;
-  do
+void ubasic_dim_arrayvariable(uint8_t varnum, uint16_t newsize)
+{
+  ubasic_dim_typedarrayvariable(varnum, newsize, 0, ARRAY_TYPE_VARIABLE);
+}
+
+void ubasic_dim_arrayvariable_2d(uint8_t varnum, uint16_t rows, uint16_t cols)
+{
+  if (cols == 0)
   {
-    mov_varnum = (arrays_data[next_location]>>16);
-    mov_size   =  arrays_data[next_location];
+    ubasic_status.bit.isRunning = 0;
+    ubasic_status.bit.Error = 1;
+    return;
+  }
+  ubasic_dim_typedarrayvariable(varnum, rows, cols, ARRAY_TYPE_VARIABLE);
+}
+
+/*---------------------------------------------------------------------------*/
+// index of element (r,c) of a two dimensional array, 0 if out of range
+static uint16_t arrays_index_2d(uint8_t varnum, VARIABLE_TYPE r, VARIABLE_TYPE c)
+{
+  int16_t  p = arrayvariable[varnum];
+  uint16_t size;
+  uint32_t idx;
+
+  if (p < 0)
+    return 0;
 
-    for (uint8_t i=0; i<=mov_size; i++)
+  size = ARRAY_HDR_SIZE(arrays_data[p]);
+  if ( (c < 1) || (c > ARRAY_HDR_COLS(arrays_data[p])) || (r < 1) || (r > size) )
+    return 0;
+
+  idx = (uint32_t) (r-1) * ARRAY_HDR_COLS(arrays_data[p]) + c;
+  return (idx > size) ? 0 : (uint16_t) idx;
+}
+
+/*---------------------------------------------------------------------------*/
+// array heap statistics, in entries: used by arrays including headers,
+// free, the largest array that can still be allocated, and the number of
+// free blocks the free entries are fragmented into
+void ubasic_array_stats(uint16_t *used, uint16_t *avail, uint16_t *largest, uint16_t *nblocks)
+{
+  int16_t p;
+  uint16_t size;
+
+  *used = *avail = *largest = *nblocks = 0;
+  for (p=0; p<VARIABLE_TYPE_ARRAY; p=ARRAY_NEXT(p))
+  {
+    size = ARRAY_HDR_WORDS(arrays_data[p]);
+    if (ARRAY_IS_FREE(p))
     {
-      arrays_data[current_location + i] = arrays_data[next_location + i];
-      arrays_data[next_location + i] = 0;
+      *avail += size + 1;
+      (*nblocks)++;
+      if (size > *largest)
+        *largest = size;
     }
-    arrayvariable[mov_varnum] = current_location;
-    next_location = next_location + mov_size + 1;
-    current_location = current_location + mov_size + 1;
-    arrays_data[current_location] = 0;
+    else
+    {
+      *used += size + 1;
+    }
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+// number of elements: for ring arrays only those pushed so far count
+static uint16_t arrays_len(int16_t p)
+{
+  return (ARRAY_HDR_RING(arrays_data[p])) ? RING_COUNT(p) : ARRAY_HDR_SIZE(arrays_data[p]);
+}
+
+// place of element i of a ring array, where element 0 is the newest one
+static uint16_t arrays_ring_index(int16_t p, uint16_t i)
+{
+  int32_t j = (int32_t) RING_HEAD(p) - 1 - i;
+  if (j < 0)
+    j += ARRAY_HDR_SIZE(arrays_data[p]);
+  return (uint16_t) j;
+}
+
+// element i (from 0) of the array at p as it is kept: the VARIABLE_TYPE
+// value for plain arrays, the integer for packed ones
+static VARIABLE_TYPE arrays_raw(int16_t p, uint16_t i)
+{
+  uint8_t *d = (uint8_t *) &arrays_data[ARRAY_DATA(p)];
+  int16_t v16;
+
+  if (ARRAY_HDR_RING(arrays_data[p]))
+    i = arrays_ring_index(p, i);
+
+  switch (ARRAY_HDR_TYPE(arrays_data[p]))
+  {
+    case ARRAY_TYPE_INT8:
+      return ((int8_t *) d)[i];
+
+    case ARRAY_TYPE_UINT8:
+      return d[i];
+
+    case ARRAY_TYPE_INT16:
+      memcpy(&v16, d + 2*i, 2);
+      return v16;
   }
-  while (arrays_data[next_location]>0);
-  free_arrayptr = current_location;
+  return arrays_data[ARRAY_DATA(p) + i].v;
+}
+
+static void arrays_setraw(int16_t p, uint16_t i, VARIABLE_TYPE v)
+{
+  uint8_t *d = (uint8_t *) &arrays_data[ARRAY_DATA(p)];
+  int16_t v16;
+
+  if (ARRAY_HDR_RING(arrays_data[p]))
+    i = arrays_ring_index(p, i);
+
+  switch (ARRAY_HDR_TYPE(arrays_data[p]))
+  {
+    case ARRAY_TYPE_INT8:
+      ((int8_t *) d)[i] = (int8_t) v;
+      return;
+
+    case ARRAY_TYPE_UINT8:
+      d[i] = (uint8_t) v;
+      return;
 
-  /** now the array should be added to the end of the list:
-      if there is space do it! */
-  goto _attach_at_the_end;
+    case ARRAY_TYPE_INT16:
+      v16 = (int16_t) v;
+      memcpy(d + 2*i, &v16, 2);
+      return;
+  }
+  arrays_data[ARRAY_DATA(p) + i].v = v;
 }
 
+/*---------------------------------------------------------------------------*/
+// packed arrays store the integer part of the value, saturated to the
+// range of the element type
 void ubasic_set_arrayvariable(uint8_t varnum, uint16_t idx,  VARIABLE_TYPE value)
 {
-  uint16_t size = (uint16_t) arrays_data[arrayvariable[varnum]];
-  if ((size < idx)||(idx<1))
+  int16_t p = arrayvariable[varnum];
+  if ( (p < 0) || (idx < 1) || (idx > arrays_len(p)) )
     return;
 
-  arrays_data[arrayvariable[varnum] + idx] = value;
+  uint8_t type = ARRAY_HDR_TYPE(arrays_data[p]);
+
+  if (type != ARRAY_TYPE_VARIABLE)
+  {
+#if defined(UBASIC_HAVE_FLOATS)
+    value = fixedpt_toint(value);
+#endif
+    if (type == ARRAY_TYPE_INT8)
+    {
+      if (value < -128)
+        value = -128;
+      else if (value > 127)
+        value = 127;
+    }
+    else if (type == ARRAY_TYPE_UINT8)
+    {
+      if (value < 0)
+        value = 0;
+      else if (value > 255)
+        value = 255;
+    }
+    else
+    {
+      if (value < -32768)
+        value = -32768;
+      else if (value > 32767)
+        value = 32767;
+    }
+  }
+
+  arrays_setraw(p, idx - 1, value);
 }
 
 VARIABLE_TYPE ubasic_get_arrayvariable(uint8_t varnum, uint16_t idx)
 {
-  uint16_t size = (uint16_t) arrays_data[arrayvariable[varnum]];
-  if ((idx>=0)&&(idx<=size))
-    return (VARIABLE_TYPE) arrays_data[arrayvariable[varnum] + idx];
-  return -1;
+  int16_t p = arrayvariable[varnum];
+  if ( (p < 0) || (idx < 1) || (idx > arrays_len(p)) )
+    return -1;
+
+  VARIABLE_TYPE r = arrays_raw(p, idx - 1);
+  if (ARRAY_HDR_TYPE(arrays_data[p]) == ARRAY_TYPE_VARIABLE)
+    return r;
+
+#if defined(UBASIC_HAVE_FLOATS)
+  r = fixedpt_fromint(r);
+#endif
+  return r;
+}
+
+/*---------------------------------------------------------------------------*/
+// bulk array functions: these work directly on arrays_data instead of
+// going through the interpreter once per element. Sums are accumulated in
+// ARRAY_ACC, twice the width of VARIABLE_TYPE, and only the result is
+// saturated to VARIABLE_TYPE. The loops over plain arrays are unrolled, as
+// the loop overhead is a good part of the cost on Cortex-M0.
+// Native floats sum in VARIABLE_TYPE itself: the values need no scaling,
+// so that ARRAY_UP and ARRAY_DOWN, s times or over 2^n, leave them as they are.
+#if defined(UBASIC_HAVE_FIXEDPT_FLOATS)
+#define ARRAY_FBITS   FIXEDPT_FBITS
+#else
+#define ARRAY_FBITS   0
+#endif
+
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+#define ARRAY_ACC     VARIABLE_TYPE
+#define ARRAY_UP(s,n)     (s)
+#define ARRAY_DOWN(s,n)   (s)
+#else
+#if defined(VARIABLE_STORAGE_INT64)
+#define ARRAY_ACC     __int128
+#define ARRAY_UACC    unsigned __int128
+#else
+#define ARRAY_ACC     int64_t
+#define ARRAY_UACC    uint64_t
+#endif
+#define ARRAY_UP(s,n)     ( (s) * ((ARRAY_ACC) 1 << (n)) )
+#define ARRAY_DOWN(s,n)   ( (s) >> (n) )
+#endif
+#define ARRAY_SIGN    ( (ARRAY_UVAR) 1 << (8 * sizeof(ARRAY_UVAR) - 1) )
+
+static VARIABLE_TYPE arrays_saturate(ARRAY_ACC s)
+{
+  if (s > VARIABLE_TYPE_MAX)
+    return VARIABLE_TYPE_MAX;
+  if (s < -VARIABLE_TYPE_MAX)
+    return -VARIABLE_TYPE_MAX;
+  return (VARIABLE_TYPE) s;
+}
+
+// fractional bits of the elements of the array at p as they are kept
+static uint8_t arrays_fbits(int16_t p)
+{
+  return (ARRAY_HDR_TYPE(arrays_data[p]) == ARRAY_TYPE_VARIABLE) ? ARRAY_FBITS : 0;
+}
+
+static ARRAY_ACC arrays_sum(int16_t p)
+{
+  uint16_t i = 0, n = arrays_len(p);
+  ARRAY_ACC s = 0;
+
+  if (ARRAY_HDR_KIND(arrays_data[p]) == ARRAY_TYPE_VARIABLE)
+  {
+    array_entry_t *a = &arrays_data[p + 1];
+    for ( ; i + 4 <= n; i += 4)
+      s += (ARRAY_ACC) a[i].v + a[i+1].v + a[i+2].v + a[i+3].v;
+    for ( ; i < n; i++)
+      s += a[i].v;
+    return s;
+  }
+
+  for ( ; i < n; i++)
+    s += arrays_raw(p, i);
+  return ARRAY_UP(s, ARRAY_FBITS - arrays_fbits(p));
+}
+
+static VARIABLE_TYPE arrays_minmax(int16_t p, uint8_t max)
+{
+  uint16_t i, n = arrays_len(p);
+  VARIABLE_TYPE r, v;
+
+  if (n == 0)
+    return 0;
+
+  r = arrays_raw(p, 0);
+  for (i = 1; i < n; i++)
+  {
+    v = arrays_raw(p, i);
+    if ( (max) ? (v > r) : (v < r) )
+      r = v;
+  }
+  return ARRAY_UP(r, ARRAY_FBITS - arrays_fbits(p));
+}
+
+// dot product over the elements the two arrays have in common
+static ARRAY_ACC arrays_dot(int16_t p, int16_t q)
+{
+  uint16_t i = 0, n = arrays_len(p);
+  int8_t shift = ARRAY_FBITS - arrays_fbits(p) - arrays_fbits(q);
+  ARRAY_ACC s = 0;
+
+  if (arrays_len(q) < n)
+    n = arrays_len(q);
+
+  if ( (ARRAY_HDR_KIND(arrays_data[p]) == ARRAY_TYPE_VARIABLE) &&
+       (ARRAY_HDR_KIND(arrays_data[q]) == ARRAY_TYPE_VARIABLE) )
+  {
+    array_entry_t *a = &arrays_data[p + 1], *b = &arrays_data[q + 1];
+    for ( ; i + 4 <= n; i += 4)
+      s += (ARRAY_ACC) a[i].v * b[i].v + (ARRAY_ACC) a[i+1].v * b[i+1].v +
+           (ARRAY_ACC) a[i+2].v * b[i+2].v + (ARRAY_ACC) a[i+3].v * b[i+3].v;
+  }
+  for ( ; i < n; i++)
+    s += (ARRAY_ACC) arrays_raw(p, i) * arrays_raw(q, i);
+
+  if (shift < 0)
+    return ARRAY_DOWN(s, -shift);
+  return ARRAY_UP(s, shift);
+}
+
+// size in bytes of the elements of the array at p
+static uint8_t arrays_esize(int16_t p)
+{
+  switch (ARRAY_HDR_TYPE(arrays_data[p]))
+  {
+    case ARRAY_TYPE_INT8:
+    case ARRAY_TYPE_UINT8:
+      return 1;
+
+    case ARRAY_TYPE_INT16:
+      return 2;
+  }
+  return sizeof(VARIABLE_TYPE);
+}
+
+static void arrays_reverse_bytes(uint8_t *d, uint16_t from, uint16_t to)
+{
+  uint8_t t;
+  while (from < --to)
+  {
+    t = d[from];
+    d[from++] = d[to];
+    d[to] = t;
+  }
+}
+
+// the first element is set as any other, after which the elements set so
+// far are copied over the rest, doubling them each time
+static void arrays_fill(uint8_t varnum, VARIABLE_TYPE value)
+{
+  int16_t p = arrayvariable[varnum];
+  uint8_t *d;
+  uint16_t done, len, total;
+
+  if ( (p < 0) || (ARRAY_HDR_SIZE(arrays_data[p]) == 0) )
+    return;
+
+  /* a ring is filled up completely, with its first element at the start */
+  if (ARRAY_HDR_RING(arrays_data[p]))
+    arrays_data[p + 1] = RING_STATE(ARRAY_HDR_SIZE(arrays_data[p]), 1 % ARRAY_HDR_SIZE(arrays_data[p]));
+
+  ubasic_set_arrayvariable(varnum, 1, value);
+  d = (uint8_t *) &arrays_data[ARRAY_DATA(p)];
+  done = arrays_esize(p);
+  total = ARRAY_HDR_SIZE(arrays_data[p]) * done;
+  while (done < total)
+  {
+    len = (total - done < done) ? total - done : done;
+    memcpy(d + done, d, len);
+    done += len;
+  }
+}
+
+#if defined(UBASIC_SCRIPT_HAVE_RANDOM_NUMBER_GENERATOR)
+// random numbers from lo up to hi, the same as lo + (hi-lo) * uniform,
+// for every element; a ring is filled up completely, as by afill
+static void arrays_rand(uint8_t varnum, VARIABLE_TYPE lo, VARIABLE_TYPE hi)
+{
+  int16_t p = arrayvariable[varnum];
+  uint16_t i, n;
+
+  if ( (p < 0) || ((n = ARRAY_HDR_SIZE(arrays_data[p])) == 0) )
+    return;
+
+  if (ARRAY_HDR_RING(arrays_data[p]))
+    arrays_data[p + 1] = RING_STATE(n, 1 % n);
+
+  hi -= lo;
+  for (i=1; i<=n; i++)
+    ubasic_set_arrayvariable(varnum, i, lo + random_uniform(hi));
+}
+#endif
+
+// shift the elements by k places, or rotate them if rotate is set. Both
+// work on the bytes of the elements, so the type of the array is of no
+// concern: rotating is done by three reversals without extra storage.
+// Returns 1 for ring arrays, which are moved along by push instead.
+static uint8_t arrays_shift(uint8_t varnum, int32_t k, uint8_t rotate)
+{
+  int16_t p = arrayvariable[varnum];
+  uint8_t *d, es;
+  uint16_t n, m;
+
+  if (p < 0)
+    return 0;
+  if (ARRAY_HDR_RING(arrays_data[p]))
+    return 1;
+
+  n = ARRAY_HDR_SIZE(arrays_data[p]);
+  if (n == 0)
+    return 0;
+  es = arrays_esize(p);
+  d = (uint8_t *) &arrays_data[p + 1];
+
+  if (rotate)
+  {
+    k %= (int32_t) n;
+    if (k < 0)
+      k += n;
+    m = (n - k) * es;
+    arrays_reverse_bytes(d, 0, m);
+    arrays_reverse_bytes(d, m, n * es);
+    arrays_reverse_bytes(d, 0, n * es);
+    return 0;
+  }
+
+  if ( (k >= n) || (k <= -(int32_t) n) )
+  {
+    memset(d, 0, n * es);
+  }
+  else if (k > 0)
+  {
+    memmove(d + k * es, d, (n - k) * es);
+    memset(d, 0, k * es);
+  }
+  else if (k < 0)
+  {
+    k = -k;
+    memmove(d, d + k * es, (n - k) * es);
+    memset(d + (n - k) * es, 0, k * es);
+  }
+  return 0;
+}
+
+// append value to a ring array as its newest element, which drops the
+// oldest one once the ring is full: returns 1 if it is not a ring array
+static uint8_t arrays_push(uint8_t varnum, VARIABLE_TYPE value)
+{
+  int16_t p = arrayvariable[varnum];
+  uint16_t n, count, head;
+
+  if ( (p < 0) || !ARRAY_HDR_RING(arrays_data[p]) )
+    return 1;
+
+  n = ARRAY_HDR_SIZE(arrays_data[p]);
+  if (n == 0)
+    return 0;
+
+  count = RING_COUNT(p);
+  head = RING_HEAD(p);
+  if (count < n)
+    count++;
+  arrays_data[p + 1] = RING_STATE(count, (head + 1 == n) ? 0 : head + 1);
+  ubasic_set_arrayvariable(varnum, 1, value);
+  return 0;
+}
+
+// take the oldest element out of a ring array, 0 if it is empty
+static VARIABLE_TYPE arrays_pop(uint8_t varnum)
+{
+  int16_t p = arrayvariable[varnum];
+  uint16_t count;
+  VARIABLE_TYPE r;
+
+  if ( (p < 0) || !ARRAY_HDR_RING(arrays_data[p]) || (RING_COUNT(p) == 0) )
+    return 0;
+
+  count = RING_COUNT(p);
+  r = ubasic_get_arrayvariable(varnum, count);
+  arrays_data[p + 1] = RING_STATE(count - 1, RING_HEAD(p));
+  return r;
+}
+
+// copy arg[2] elements of array src, starting at arg[0], to array dst
+// starting at arg[1]: the count defaults to as many as fit. Between arrays
+// of the same type the bytes are moved as they are, overlapping or not.
+// Returns 1 if the range is outside of either array.
+static uint8_t arrays_copy(uint8_t dst, uint8_t src, VARIABLE_TYPE *arg)
+{
+  int16_t p = arrayvariable[dst], q = arrayvariable[src];
+  int32_t s = arg[0], t = arg[1], n = arg[2];
+  uint8_t es;
+
+  if ( (p < 0) || (q < 0) || (s < 1) || (t < 1) )
+    return 1;
+
+  if (n < 0)
+  {
+    n = arrays_len(q) - s + 1;
+    if (arrays_len(p) - t + 1 < n)
+      n = arrays_len(p) - t + 1;
+    if (n < 0)
+      return 1;
+  }
+  if ( (s + n - 1 > arrays_len(q)) || (t + n - 1 > arrays_len(p)) )
+    return 1;
+
+  if ( (ARRAY_HDR_TYPE(arrays_data[p]) == ARRAY_HDR_TYPE(arrays_data[q])) &&
+       !ARRAY_HDR_RING(arrays_data[p]) && !ARRAY_HDR_RING(arrays_data[q]) )
+  {
+    es = arrays_esize(p);
+    memmove((uint8_t *) &arrays_data[p + 1] + (t - 1) * es,
+            (uint8_t *) &arrays_data[q + 1] + (s - 1) * es, n * es);
+    return 0;
+  }
+
+  /* element by element, backwards if that is needed within one array */
+  if ( (p == q) && (t > s) )
+  {
+    for ( ; n > 0; n--)
+      ubasic_set_arrayvariable(dst, t + n - 1, ubasic_get_arrayvariable(src, s + n - 1));
+    return 0;
+  }
+  for ( ; n > 0; n--)
+    ubasic_set_arrayvariable(dst, t++, ubasic_get_arrayvariable(src, s++));
+  return 0;
+}
+
+// sorting: quicksort on the elements as they are kept, with the pivot a
+// median of three, insertion sort for short ranges and heapsort once the
+// partitioning goes too deep (introsort). The recursion is on the shorter
+// part only, so no more than log2(n) levels of it are ever on the stack.
+#define ARRAYS_BEFORE(x,y)  ( (desc) ? ((y) < (x)) : ((x) < (y)) )
+
+static void arrays_swap(int16_t p, int32_t i, int32_t j)
+{
+  VARIABLE_TYPE t = arrays_raw(p, i);
+  arrays_setraw(p, i, arrays_raw(p, j));
+  arrays_setraw(p, j, t);
+}
+
+static void arrays_insertion_sort(int16_t p, int32_t lo, int32_t hi, uint8_t desc)
+{
+  int32_t i, j;
+  VARIABLE_TYPE v;
+
+  for (i = lo + 1; i < hi; i++)
+  {
+    v = arrays_raw(p, i);
+    for (j = i; (j > lo) && ARRAYS_BEFORE(v, arrays_raw(p, j - 1)); j--)
+      arrays_setraw(p, j, arrays_raw(p, j - 1));
+    arrays_setraw(p, j, v);
+  }
+}
+
+static void arrays_sift_down(int16_t p, int32_t lo, int32_t root, int32_t n, uint8_t desc)
+{
+  int32_t child;
+
+  while ( (child = 2*root + 1) < n )
+  {
+    if ( (child + 1 < n) && ARRAYS_BEFORE(arrays_raw(p, lo + child), arrays_raw(p, lo + child + 1)) )
+      child++;
+    if (!ARRAYS_BEFORE(arrays_raw(p, lo + root), arrays_raw(p, lo + child)))
+      return;
+    arrays_swap(p, lo + root, lo + child);
+    root = child;
+  }
+}
+
+static void arrays_heap_sort(int16_t p, int32_t lo, int32_t hi, uint8_t desc)
+{
+  int32_t i, n = hi - lo;
+
+  for (i = n/2; i-- > 0; )
+    arrays_sift_down(p, lo, i, n, desc);
+  for (i = n - 1; i > 0; i--)
+  {
+    arrays_swap(p, lo, lo + i);
+    arrays_sift_down(p, lo, 0, i, desc);
+  }
+}
+
+// sort the elements lo to hi-1
+static void arrays_sort(int16_t p, int32_t lo, int32_t hi, uint8_t depth, uint8_t desc)
+{
+  int32_t i, j, mid;
+  VARIABLE_TYPE pivot;
+
+  while (hi - lo > 16)
+  {
+    if (depth-- == 0)
+    {
+      arrays_heap_sort(p, lo, hi, desc);
+      return;
+    }
+
+    mid = lo + (hi - lo)/2;
+    if (ARRAYS_BEFORE(arrays_raw(p, mid), arrays_raw(p, lo)))
+      arrays_swap(p, mid, lo);
+    if (ARRAYS_BEFORE(arrays_raw(p, hi - 1), arrays_raw(p, lo)))
+      arrays_swap(p, hi - 1, lo);
+    if (ARRAYS_BEFORE(arrays_raw(p, hi - 1), arrays_raw(p, mid)))
+      arrays_swap(p, hi - 1, mid);
+    pivot = arrays_raw(p, mid);
+
+    i = lo - 1;
+    j = hi;
+    for (;;)
+    {
+      do i++; while (ARRAYS_BEFORE(arrays_raw(p, i), pivot));
+      do j--; while (ARRAYS_BEFORE(pivot, arrays_raw(p, j)));
+      if (i >= j)
+        break;
+      arrays_swap(p, i, j);
+    }
+
+    j++;
+    if (j - lo < hi - j)
+    {
+      arrays_sort(p, lo, j, depth, desc);
+      lo = j;
+    }
+    else
+    {
+      arrays_sort(p, j, hi, depth, desc);
+      hi = j;
+    }
+  }
+  arrays_insertion_sort(p, lo, hi, desc);
+}
+
+static void arrays_sort_all(uint8_t varnum, uint8_t desc)
+{
+  int16_t p = arrayvariable[varnum];
+  uint16_t n;
+  uint8_t depth = 0;
+
+  if (p < 0)
+    return;
+
+  n = arrays_len(p);
+  while (n >>= 1)
+    depth += 2;
+  arrays_sort(p, 0, arrays_len(p), depth, desc);
+}
+
+// the value as an unsigned key in the same order: offset binary for
+// integers, and for floats the sign bit set on positive numbers and all
+// bits flipped on negative ones
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+static ARRAY_UVAR arrays_key(VARIABLE_TYPE v)
+{
+  ARRAY_UVAR u;
+  memcpy(&u, &v, sizeof(u));
+  return (u & ARRAY_SIGN) ? ~u : (u | ARRAY_SIGN);
+}
+
+static VARIABLE_TYPE arrays_unkey(ARRAY_UVAR u)
+{
+  VARIABLE_TYPE v;
+  u = (u & ARRAY_SIGN) ? (u & ~ARRAY_SIGN) : ~u;
+  memcpy(&v, &u, sizeof(v));
+  return v;
+}
+#else
+#define arrays_key(v)     ( (ARRAY_UVAR) (v) ^ ARRAY_SIGN )
+#define arrays_unkey(u)   ( (VARIABLE_TYPE) ((u) ^ ARRAY_SIGN) )
+#endif
+
+// k-th smallest (from 0) element of the array at p, as it is kept, found
+// bit by bit from the top of its key without reordering the array or extra
+// storage: one pass over the elements per bit
+static VARIABLE_TYPE arrays_select(int16_t p, uint16_t k)
+{
+  uint16_t i, n = arrays_len(p), cnt;
+  ARRAY_UVAR u, prefix = 0, mask = 0, bit;
+
+  for (bit = ARRAY_SIGN; bit; bit >>= 1)
+  {
+    cnt = 0;
+    for (i = 0; i < n; i++)
+    {
+      u = arrays_key(arrays_raw(p, i));
+      if ( ((u & mask) == prefix) && !(u & bit) )
+        cnt++;
+    }
+    if (k >= cnt)
+    {
+      k -= cnt;
+      prefix |= bit;
+    }
+    mask |= bit;
+  }
+  return arrays_unkey(prefix);
+}
+
+// number of elements of the ascending sorted array a that are not greater
+// than value, which is the index of the last of them
+static VARIABLE_TYPE arrays_find(uint8_t a, VARIABLE_TYPE value)
+{
+  int16_t p = arrayvariable[a];
+  int32_t lo = 0, hi, mid;
+  ARRAY_ACC scale;
+
+  if (p < 0)
+    return 0;
+
+  hi = arrays_len(p);
+  scale = ARRAY_UP((ARRAY_ACC) 1, ARRAY_FBITS - arrays_fbits(p));
+  while (lo < hi)
+  {
+    mid = lo + (hi - lo)/2;
+    if (arrays_raw(p, mid) * scale <= value)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+#if defined(UBASIC_HAVE_FLOATS)
+  return fixedpt_fromint(lo);
+#else
+  return lo;
+#endif
+}
+
+// asum, amin, amax, amean, amedian of array a, adot of arrays a and b
+static VARIABLE_TYPE arrays_reduce(uint8_t token, uint8_t a, uint8_t b)
+{
+  int16_t p = arrayvariable[a], q = arrayvariable[b];
+  uint16_t n;
+  ARRAY_ACC s;
+
+  if ( (p < 0) || (q < 0) )
+    return 0;
+
+  n = arrays_len(p);
+  switch (token)
+  {
+    case TOKENIZER_ASUM:
+      return arrays_saturate(arrays_sum(p));
+
+    case TOKENIZER_AMEAN:
+      return (n) ? arrays_saturate(arrays_sum(p) / n) : 0;
+
+    case TOKENIZER_AMIN:
+    case TOKENIZER_AMAX:
+      return arrays_minmax(p, token == TOKENIZER_AMAX);
+
+    case TOKENIZER_AMEDIAN:
+      if (n == 0)
+        return 0;
+      s = arrays_select(p, (n - 1)/2);
+      if ((n & 1) == 0)
+        s += arrays_select(p, n/2);
+      s = ARRAY_UP(s, ARRAY_FBITS - arrays_fbits(p));
+      return (VARIABLE_TYPE) (((n & 1) == 0) ? s/2 : s);
+  }
+  return arrays_saturate(arrays_dot(p, q));
+}
+
+/*---------------------------------------------------------------------------*/
+// interp: y at x on the broken line through the points (xs(i), ys(i)), with
+// xs increasing or decreasing. Outside of xs the end values of ys are
+// returned. The segment is found by bisection, and the fraction of it is
+// taken in 64 bits, so that it does not matter how the values are scaled.
+static VARIABLE_TYPE arrays_interp(VARIABLE_TYPE x, uint8_t xs, uint8_t ys)
+{
+  uint16_t lo, hi, mid, n = arrays_len(arrayvariable[xs]);
+  VARIABLE_TYPE x0, x1, y0, y1;
+  uint8_t down;
+
+  if (arrays_len(arrayvariable[ys]) < n)
+    n = arrays_len(arrayvariable[ys]);
+  if (n == 0)
+    return 0;
+
+  /* bring decreasing breakpoints to increasing by negating them */
+  down = ubasic_get_arrayvariable(xs, n) < ubasic_get_arrayvariable(xs, 1);
+  if (down)
+    x = -x;
+
+  if (x <= ((down) ? -ubasic_get_arrayvariable(xs, 1) : ubasic_get_arrayvariable(xs, 1)))
+    return ubasic_get_arrayvariable(ys, 1);
+  if (x >= ((down) ? -ubasic_get_arrayvariable(xs, n) : ubasic_get_arrayvariable(xs, n)))
+    return ubasic_get_arrayvariable(ys, n);
+
+  /* xs(lo) < x < xs(hi) */
+  lo = 1;
+  hi = n;
+  while (hi - lo > 1)
+  {
+    mid = lo + (hi - lo) / 2;
+    x0 = ubasic_get_arrayvariable(xs, mid);
+    if (down)
+      x0 = -x0;
+    if (x0 <= x)
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+  x0 = ubasic_get_arrayvariable(xs, lo);
+  x1 = ubasic_get_arrayvariable(xs, hi);
+  if (down)
+  {
+    x0 = -x0;
+    x1 = -x1;
+  }
+  y0 = ubasic_get_arrayvariable(ys, lo);
+  y1 = ubasic_get_arrayvariable(ys, hi);
+  if (x1 == x0)
+    return y0;
+  return arrays_saturate(y0 + ((ARRAY_ACC) y1 - y0) * ((ARRAY_ACC) x - x0) / ((ARRAY_ACC) x1 - x0));
+}
+
+// polyval: c(1) x^(n-1) + ... + c(n-1) x + c(n) by Horner's rule
+static VARIABLE_TYPE arrays_polyval(VARIABLE_TYPE x, uint8_t c)
+{
+  uint16_t i, n = arrays_len(arrayvariable[c]);
+  VARIABLE_TYPE r = 0;
+
+  for (i = 1; i <= n; i++)
+    r = arrays_saturate(ARRAY_DOWN((ARRAY_ACC) r * x, ARRAY_FBITS) + ubasic_get_arrayvariable(c, i));
+  return r;
+}
+
+/*---------------------------------------------------------------------------*/
+// matrices are plain two dimensional arrays, stored row by row. Each
+// element of a product is summed exactly in 64 bits and shifted once, so
+// that it is the same as fixedpt_xmul for a single product. The result
+// array is dimensioned to fit, and may not be one of the arguments.
+
+// rows and columns of a plain two dimensional array, 0 if it is not one
+static uint8_t arrays_shape(int16_t p, uint16_t *rows, uint16_t *cols)
+{
+  *cols = ARRAY_HDR_COLS(arrays_data[p]);
+  if ( (*cols == 0) || (ARRAY_HDR_KIND(arrays_data[p]) != ARRAY_TYPE_VARIABLE) )
+    return 0;
+  *rows = ARRAY_HDR_SIZE(arrays_data[p]) / *cols;
+  return 1;
+}
+
+// sum of a[i] b[i*stride], unrolled for the 3x3 and 4x4 matrices of
+// orientation and calibration math. The loop with stride 1 is kept simple
+// so that it is vectorised when built for a host.
+static ARRAY_ACC arrays_mdot(const array_entry_t *a, const array_entry_t *b, uint16_t stride, uint16_t n)
+{
+  ARRAY_ACC s = 0;
+  uint16_t i;
+
+  switch (n)
+  {
+    case 4:
+      s = (ARRAY_ACC) a[3].v * b[3*stride].v;
+      /* fall through */
+    case 3:
+      return s + (ARRAY_ACC) a[0].v * b[0].v + (ARRAY_ACC) a[1].v * b[stride].v +
+                 (ARRAY_ACC) a[2].v * b[2*stride].v;
+  }
+
+  if (stride == 1)
+  {
+    for (i = 0; i < n; i++)
+      s += (ARRAY_ACC) a[i].v * b[i].v;
+    return s;
+  }
+  for (i = 0; i < n; i++, b += stride)
+    s += (ARRAY_ACC) a[i].v * b->v;
+  return s;
+}
+
+// token tells matmul (a = b c), matvec (a = b c, c a vector) and mattrans
+// (a = b transposed): returns 1 if the shapes do not fit
+static uint8_t arrays_matrix(uint8_t token, uint8_t a, uint8_t b, uint8_t c)
+{
+  array_entry_t *x, *y, *z, t;
+  uint16_t rows, cols, n = 1, m = 1, i, j;
+
+  if ( !arrays_shape(arrayvariable[b], &rows, &cols) )
+    return 1;
+
+  if (token == TOKENIZER_MATTRANS)
+  {
+    if (a == b)
+    {
+      if (rows != cols)
+        return 1;
+      x = &arrays_data[arrayvariable[a] + 1];
+      for (i = 0; i < rows; i++)
+        for (j = i + 1; j < cols; j++)
+        {
+          t = x[i*cols + j];
+          x[i*cols + j] = x[j*cols + i];
+          x[j*cols + i] = t;
+        }
+      return 0;
+    }
+    ubasic_dim_arrayvariable_2d(a, cols, rows);
+    if (ubasic_status.bit.Error)
+      return 1;
+    x = &arrays_data[arrayvariable[a] + 1];
+    y = &arrays_data[arrayvariable[b] + 1];
+    for (i = 0; i < rows; i++)
+      for (j = 0; j < cols; j++)
+        x[j*rows + i] = y[i*cols + j];
+    return 0;
+  }
+
+  if ( (a == b) || (a == c) ||
+       (ARRAY_HDR_KIND(arrays_data[arrayvariable[c]]) != ARRAY_TYPE_VARIABLE) )
+    return 1;
+
+  if (token == TOKENIZER_MATMUL)
+  {
+    if ( !arrays_shape(arrayvariable[c], &n, &m) || (n != cols) )
+      return 1;
+    ubasic_dim_arrayvariable_2d(a, rows, m);
+  }
+  else
+  {
+    if (ARRAY_HDR_SIZE(arrays_data[arrayvariable[c]]) != cols)
+      return 1;
+    ubasic_dim_arrayvariable(a, rows);
+  }
+  if (ubasic_status.bit.Error)
+    return 1;
+
+  /* dimensioning a may have moved b and c */
+  x = &arrays_data[arrayvariable[a] + 1];
+  y = &arrays_data[arrayvariable[b] + 1];
+  z = &arrays_data[arrayvariable[c] + 1];
+  for (i = 0; i < rows; i++)
+    for (j = 0; j < m; j++)
+      (x++)->v = arrays_saturate(ARRAY_DOWN(arrays_mdot(y + i*cols, z + j, m, cols), ARRAY_FBITS));
+  return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+// filters: filter_init turns the array f into a filter with the
+// coefficients from the array c, and filter() runs one sample through it.
+// The filter keeps everything in f, as values as they are kept:
+//   FIR with n taps:  (n<<1), newest, n coefficients, n past inputs
+//   k biquads:        (k<<1)|1, 0, k x (b0 b1 b2 a1 a2), k x (x1 x2 y1 y2)
+// where a biquad section computes
+//   y = b0 x + b1 x1 + b2 x2 - a1 y1 - a2 y2
+// The products are summed in 64 bits and rounded once per output.
+#define FILTER_HDR      2
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+#define FILTER_ROUND(s) (s)
+#else
+#define FILTER_ROUND(s) ( ((s) + (((ARRAY_ACC) 1 << ARRAY_FBITS) >> 1)) >> ARRAY_FBITS )
+#endif
+
+static uint16_t arrays_filter_size(uint16_t n, uint8_t biquad)
+{
+  return FILTER_HDR + ((biquad) ? 9 * n : 2 * n);
+}
+
+// returns 1 if c cannot be used, or if there is no room for f
+static uint8_t arrays_filter_init(uint8_t f, uint8_t c, uint8_t biquad)
+{
+  array_entry_t *d;
+  uint16_t i, n, nc, size;
+
+  n = nc = arrays_len(arrayvariable[c]);
+  if ( (f == c) || (n == 0) || (biquad && (n % 5)) )
+    return 1;
+  if (biquad)
+    n /= 5;
+
+  size = arrays_filter_size(n, biquad);
+  ubasic_dim_arrayvariable(f, size);
+  if (ubasic_status.bit.Error)
+    return 1;
+
+  /* c may have been moved, so it is read by index */
+  d = &arrays_data[arrayvariable[f] + 1];
+  d[0].v = (VARIABLE_TYPE) ((n << 1) | biquad);
+  d[1].v = 0;
+  for (i = 0; i < size - FILTER_HDR; i++)
+    d[FILTER_HDR + i].v = (i < nc) ? ubasic_get_arrayvariable(c, i + 1) : 0;
+  return 0;
+}
+
+// x in, filtered x out: returns 1 if f is not a filter
+static uint8_t arrays_filter(uint8_t f, VARIABLE_TYPE *x)
+{
+  int16_t p = arrayvariable[f];
+  array_entry_t *d, *c, *h;
+  VARIABLE_TYPE y;
+  uint16_t n, i, k;
+  int32_t j;
+  ARRAY_ACC s;
+
+  d = &arrays_data[p + 1];
+  n = (uint16_t) ((uint32_t) d[0].v >> 1);
+  if ( (ARRAY_HDR_KIND(arrays_data[p]) != ARRAY_TYPE_VARIABLE) || (n == 0) ||
+       (ARRAY_HDR_SIZE(arrays_data[p]) != arrays_filter_size(n, (uint32_t) d[0].v & 1)) )
+    return 1;
+
+  c = d + FILTER_HDR;
+  if ((uint32_t) d[0].v & 1)
+  {
+    /* cascade of biquads, direct form I */
+    h = c + 5 * n;
+    y = *x;
+    for (k = 0; k < n; k++, c += 5, h += 4)
+    {
+      s = (ARRAY_ACC) c[0].v * y + (ARRAY_ACC) c[1].v * h[0].v + (ARRAY_ACC) c[2].v * h[1].v
+          - (ARRAY_ACC) c[3].v * h[2].v - (ARRAY_ACC) c[4].v * h[3].v;
+      h[1].v = h[0].v;
+      h[0].v = y;
+      y = arrays_saturate(FILTER_ROUND(s));
+      h[3].v = h[2].v;
+      h[2].v = y;
+    }
+    *x = y;
+    return 0;
+  }
+
+  /* FIR: the past inputs are a ring, coefficient 0 goes with the newest */
+  h = c + n;
+  j = d[1].v + 1;
+  if ( (j < 0) || (j >= n) )
+    j = 0;
+  d[1].v = j;
+  h[j].v = *x;
+
+  s = 0;
+  for (i = 0; j >= 0; i++, j--)
+    s += (ARRAY_ACC) c[i].v * h[j].v;
+  for (j = n - 1; i < n; i++, j--)
+    s += (ARRAY_ACC) c[i].v * h[j].v;
+  *x = arrays_saturate(FILTER_ROUND(s));
+  return 0;
+}
+
+#if defined(UBASIC_SCRIPT_HAVE_FFT)
+/*---------------------------------------------------------------------------*/
+// fft: in place radix-2 transform of the arrays re and im, whose elements
+// are taken as they are kept, so that it works the same on fixed point and
+// on integer values. The twiddle factors come from a quarter of a sine
+// period in Q15 for transforms of up to FFT_MAX_SIZE points, while native
+// floats take them from libm.
+#define FFT_MAX_SIZE    1024
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+typedef VARIABLE_TYPE   fft_twiddle_t;
+#define FFT_Q15(s)      (s)
+#define FFT_HALF(s)     ((s) / 2)
+
+// cos and sin of 2*pi*k/FFT_MAX_SIZE
+static void fft_twiddle(uint16_t k, fft_twiddle_t *c, fft_twiddle_t *s)
+{
+  VARIABLE_TYPE w = (VARIABLE_TYPE) k * (VARIABLE_TYPE) (NATIVEFP_2PI / FFT_MAX_SIZE);
+  *c = fixedpt_cos(w);
+  *s = fixedpt_sin(w);
+}
+#else
+typedef int32_t         fft_twiddle_t;
+#define FFT_Q15(s)      ( ((s) + (1 << 14)) >> 15 )
+#define FFT_HALF(s)     ( ((s) + 1) >> 1 )
+#if defined(FIXEDPT_SIN_Q15_SIZE) && (FIXEDPT_SIN_Q15_SIZE == FFT_MAX_SIZE)
+/* the same table serves sin and cos of the fixed point library */
+#define fft_sin_q15     fixedpt_sin_q15
+#else
+static const uint16_t fft_sin_q15[FFT_MAX_SIZE/4 + 1] =
+{
+      0,   201,   402,   603,   804,  1005,  1206,  1407,  1608,  1809,
+   2009,  2210,  2411,  2611,  2811,  3012,  3212,  3412,  3612,  3812,
+   4011,  4211,  4410,  4609,  4808,  5007,  5205,  5404,  5602,  5800,
+   5998,  6195,  6393,  6590,  6787,  6983,  7180,  7376,  7571,  7767,
+   7962,  8157,  8351,  8546,  8740,  8933,  9127,  9319,  9512,  9704,
+   9896, 10088, 10279, 10469, 10660, 10850, 11039, 11228, 11417, 11605,
+  11793, 11980, 12167, 12354, 12540, 12725, 12910, 13095, 13279, 13463,
+  13646, 13828, 14010, 14192, 14373, 14553, 14733, 14912, 15091, 15269,
+  15447, 15624, 15800, 15976, 16151, 16326, 16500, 16673, 16846, 17018,
+  17190, 17361, 17531, 17700, 17869, 18037, 18205, 18372, 18538, 18703,
+  18868, 19032, 19195, 19358, 19520, 19681, 19841, 20001, 20160, 20318,
+  20475, 20632, 20788, 20943, 21097, 21251, 21403, 21555, 21706, 21856,
+  22006, 22154, 22302, 22449, 22595, 22740, 22884, 23028, 23170, 23312,
+  23453, 23593, 23732, 23870, 24008, 24144, 24279, 24414, 24548, 24680,
+  24812, 24943, 25073, 25202, 25330, 25457, 25583, 25708, 25833, 25956,
+  26078, 26199, 26320, 26439, 26557, 26674, 26791, 26906, 27020, 27133,
+  27246, 27357, 27467, 27576, 27684, 27791, 27897, 28002, 28106, 28209,
+  28311, 28411, 28511, 28610, 28707, 28803, 28899, 28993, 29086, 29178,
+  29269, 29359, 29448, 29535, 29622, 29707, 29792, 29875, 29957, 30038,
+  30118, 30196, 30274, 30350, 30425, 30499, 30572, 30644, 30715, 30784,
+  30853, 30920, 30986, 31050, 31114, 31177, 31238, 31298, 31357, 31415,
+  31471, 31527, 31581, 31634, 31686, 31737, 31786, 31834, 31881, 31927,
+  31972, 32015, 32058, 32099, 32138, 32177, 32214, 32251, 32286, 32319,
+  32352, 32383, 32413, 32442, 32470, 32496, 32522, 32546, 32568, 32590,
+  32610, 32629, 32647, 32664, 32679, 32693, 32706, 32718, 32729, 32738,
+  32746, 32753, 32758, 32762, 32766, 32767, 32768
+};
+#endif
+
+// cos and sin of 2*pi*k/FFT_MAX_SIZE for 0 <= k < FFT_MAX_SIZE/2
+static void fft_twiddle(uint16_t k, fft_twiddle_t *c, fft_twiddle_t *s)
+{
+  if (k <= FFT_MAX_SIZE/4)
+  {
+    *c = fft_sin_q15[FFT_MAX_SIZE/4 - k];
+    *s = fft_sin_q15[k];
+  }
+  else
+  {
+    *c = -(int32_t) fft_sin_q15[k - FFT_MAX_SIZE/4];
+    *s = fft_sin_q15[FFT_MAX_SIZE/2 - k];
+  }
+}
+#endif
+
+// The forward transform halves the values after each stage, so that it
+// cannot overflow and returns the spectrum divided by the number of points,
+// while the inverse one does not scale: inverse of forward gives back the
+// input. Returns 1 unless both are plain arrays of the same size, a power
+// of 2 up to FFT_MAX_SIZE.
+static uint8_t arrays_fft(uint8_t a, uint8_t b, uint8_t inverse)
+{
+  int16_t p = arrayvariable[a], q = arrayvariable[b];
+  array_entry_t *xr, *xi, t;
+  uint16_t n, i, j, k, m, half, step;
+  fft_twiddle_t c, s;
+  ARRAY_ACC tr, ti, ur, ui;
+
+  if ( (p < 0) || (q < 0) || (p == q) ||
+       (ARRAY_HDR_KIND(arrays_data[p]) != ARRAY_TYPE_VARIABLE) ||
+       (ARRAY_HDR_KIND(arrays_data[q]) != ARRAY_TYPE_VARIABLE) )
+    return 1;
+
+  n = ARRAY_HDR_SIZE(arrays_data[p]);
+  if ( (n != ARRAY_HDR_SIZE(arrays_data[q])) || (n > FFT_MAX_SIZE) || (n & (n - 1)) )
+    return 1;
+  if (n < 2)
+    return 0;
+
+  xr = &arrays_data[p + 1];
+  xi = &arrays_data[q + 1];
+
+  /* bit reversed order */
+  for (i = 1, j = 0; i < n; i++)
+  {
+    for (k = n >> 1; j & k; k >>= 1)
+      j ^= k;
+    j |= k;
+    if (i < j)
+    {
+      t = xr[i]; xr[i] = xr[j]; xr[j] = t;
+      t = xi[i]; xi[i] = xi[j]; xi[j] = t;
+    }
+  }
+
+  for (m = 2; m <= n; m <<= 1)
+  {
+    half = m >> 1;
+    step = FFT_MAX_SIZE / m;
+    for (k = 0; k < half; k++)
+    {
+      fft_twiddle(k * step, &c, &s);
+      if (!inverse)
+        s = -s;
+      for (i = k; i < n; i += m)
+      {
+        j = i + half;
+        tr = FFT_Q15((ARRAY_ACC) xr[j].v * c - (ARRAY_ACC) xi[j].v * s);
+        ti = FFT_Q15((ARRAY_ACC) xr[j].v * s + (ARRAY_ACC) xi[j].v * c);
+        ur = xr[i].v;
+        ui = xi[i].v;
+        if (inverse)
+        {
+          xr[i].v = arrays_saturate(ur + tr);
+          xi[i].v = arrays_saturate(ui + ti);
+          xr[j].v = arrays_saturate(ur - tr);
+          xi[j].v = arrays_saturate(ui - ti);
+        }
+        else
+        {
+          xr[i].v = arrays_saturate(FFT_HALF(ur + tr));
+          xi[i].v = arrays_saturate(FFT_HALF(ui + ti));
+          xr[j].v = arrays_saturate(FFT_HALF(ur - tr));
+          xi[j].v = arrays_saturate(FFT_HALF(ui - ti));
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+#if !defined(VARIABLE_TYPE_FLOAT_NATIVE)
+// square root of an ARRAY_UACC integer, rounded down
+static ARRAY_UACC arrays_isqrt(ARRAY_UACC x)
+{
+  ARRAY_UACC r = 0, bit = (ARRAY_UACC) 1 << (8 * sizeof(ARRAY_UACC) - 2);
+
+  while (bit > x)
+    bit >>= 2;
+  while (bit)
+  {
+    if (x >= r + bit)
+    {
+      x -= r + bit;
+      r = (r >> 1) + bit;
+    }
+    else
+      r >>= 1;
+    bit >>= 2;
+  }
+  return r;
+}
+#endif
+
+// amag: m(i) = sqrt(re(i)^2 + im(i)^2) over the elements all three have
+static void arrays_mag(uint8_t m, uint8_t a, uint8_t b)
+{
+  uint16_t i, n = arrays_len(arrayvariable[m]);
+  ARRAY_ACC x, y;
+
+  if (arrays_len(arrayvariable[a]) < n)
+    n = arrays_len(arrayvariable[a]);
+  if (arrays_len(arrayvariable[b]) < n)
+    n = arrays_len(arrayvariable[b]);
+
+  for (i = 1; i <= n; i++)
+  {
+    x = ubasic_get_arrayvariable(a, i);
+    y = ubasic_get_arrayvariable(b, i);
+#if defined(VARIABLE_TYPE_FLOAT_NATIVE)
+    ubasic_set_arrayvariable(m, i, fixedpt_sqrt(x*x + y*y));
+#else
+    ubasic_set_arrayvariable(m, i, arrays_saturate(arrays_isqrt((ARRAY_UACC) (x*x) + (ARRAY_UACC) (y*y))));
+#endif
+  }
 }
+#endif /* UBASIC_SCRIPT_HAVE_FFT */
 #endif
 /*---------------------------------------------------------------------------*/
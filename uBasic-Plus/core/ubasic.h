@@ -57,9 +57,19 @@ VARIABLE_TYPE ubasic_get_variable(uint8_t varnum);
 void ubasic_set_variable(uint8_t varum, VARIABLE_TYPE value);
 
 #if defined(VARIABLE_TYPE_ARRAY)
-void ubasic_dim_arrayvariable(uint8_t varnum, int16_t size);
+// element types of packed arrays: dim a@(n) as int8|uint8|int16
+#define ARRAY_TYPE_VARIABLE   0
+#define ARRAY_TYPE_INT8       1
+#define ARRAY_TYPE_UINT8      2
+#define ARRAY_TYPE_INT16      3
+// or-ed with the element type: ring array, dim a@(n) ring
+#define ARRAY_TYPE_RING       4
+void ubasic_dim_arrayvariable(uint8_t varnum, uint16_t size);
+void ubasic_dim_arrayvariable_2d(uint8_t varnum, uint16_t rows, uint16_t cols);
+void ubasic_dim_typedarrayvariable(uint8_t varnum, uint16_t rows, uint16_t cols, uint8_t type);
 void ubasic_set_arrayvariable(uint8_t varnum, uint16_t idx,  VARIABLE_TYPE value);
 VARIABLE_TYPE ubasic_get_arrayvariable(uint8_t varnum, uint16_t idx);
+void ubasic_array_stats(uint16_t *used, uint16_t *avail, uint16_t *largest, uint16_t *nblocks);
 #endif
 
 #if defined(VARIABLE_TYPE_STRING)
@@ -69,4 +79,10 @@ void  ubasic_set_stringvariable(uint8_t, int16_t);
 // end of string addition
 #endif
 
+#if defined(VARIABLE_TYPE_STRING_ARRAY)
+void ubasic_dim_stringarrayvariable(uint8_t svarnum, int16_t size);
+void ubasic_set_stringarrayvariable(uint8_t svarnum, uint16_t idx, int16_t svalue);
+int16_t ubasic_get_stringarrayvariable(uint8_t svarnum, uint16_t idx);
+#endif
+
 #endif /* __UBASIC_H__ */
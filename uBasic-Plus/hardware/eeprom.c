@@ -62,7 +62,8 @@ static HAL_StatusTypeDef EE_Format(void)
 /**
   * @brief  EE_WriteVariable
   *     @arg NAME: Index of variable  Name-'a'
-  *     @arg Vartype: 0-4byte (fixed point) float, 1-string of nonzero length, 2-(fp)f array
+  *     @arg Vartype: 0-4byte (fixed point) float, 1-string of nonzero length, 2-(fp)f array,
+  *                   3-two dimensional (fp)f array with its header as first entry
   *     @arg Datalen: length of data
   *     @arg dataptr: pointer to data storage
   * @retval None
@@ -71,7 +72,8 @@ void EE_WriteVariable(uint8_t Name, uint8_t Vartype,
                       uint8_t datalen_bytes, uint8_t *dataptr)
 {
   /* What is variable headless header:
-   *  [7:6] -> variable type: 0-4byte (fixed point) float, 1-string of nonzero length, 2-(fp)f array
+   *  [7:6] -> variable type: 0-4byte (fixed point) float, 1-string of nonzero length, 2-(fp)f array,
+   *           3-two dimensional (fp)f array
    *  [5:0] -> variable name index as in Name-'a', for Name=a,b,c..z
    *
    */
@@ -99,7 +101,7 @@ void EE_WriteVariable(uint8_t Name, uint8_t Vartype,
       EE_FULLHEADER_TYPE  full_header = (*(__IO EE_FULLHEADER_TYPE *)PageCheckAddress);
       EE_HEADER_TYPE check_header = EE_FULLHEADER_HEADER(full_header);
       EE_HEADER_TYPE len          = EE_FULLHEADER_DATALEN(full_header)>>1;
-      if ( headless_header == check_header )
+      if ( EE_SAME_VARIABLE(headless_header, check_header) )
       {
         HAL_FLASH_Unlock();
 #if defined(EE_ERASE_FULL)
@@ -132,7 +134,7 @@ void EE_WriteVariable(uint8_t Name, uint8_t Vartype,
   }
 
   
-  if ((Vartype == UBASIC_VAR_FLOAT) || (Vartype == UBASIC_VAR_ARRAY))
+  if ((Vartype == UBASIC_VAR_FLOAT) || (Vartype == UBASIC_VAR_ARRAY) || (Vartype == UBASIC_VAR_MATRIX))
   {
     HAL_FLASH_Unlock();
 #if defined(EE_HEADER_FORMAT_16)
@@ -371,6 +373,10 @@ void EE_DumpFlash(void)
     {
       print_serial("@ (array)\n");
     }
+    else if (EE_VARTYPE(header) == 3)
+    {
+      print_serial("@ (2d/packed array)\n");
+    }
     sprintf(msg, "  Size:%u+%u bytes\n", sizeof(header), EE_FULLHEADER_DATALEN(header));
     print_serial(msg);
 
@@ -65,6 +65,11 @@
 #define UBASIC_VAR_FLOAT  (0)
 #define UBASIC_VAR_STRING (1)
 #define UBASIC_VAR_ARRAY  (2)
+#define UBASIC_VAR_MATRIX (3)
+/* arrays stored with their header: two dimensional or packed */
+/* one and two dimensional arrays of the same name replace each other */
+#define EE_SAME_VARIABLE(a,b) ( ((a) == (b)) || \
+  ( (EE_VARNAME(a) == EE_VARNAME(b)) && (EE_VARTYPE(a) >= UBASIC_VAR_ARRAY) && (EE_VARTYPE(b) >= UBASIC_VAR_ARRAY) ) )
 
 #if defined(EE_HEADER_FORMAT_16)
 /* General concept:
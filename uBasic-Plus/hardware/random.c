@@ -1,4 +1,5 @@
 #include "main.h"
+#include "../core/config.h"
 
 
 #undef CRC_SALT_I
@@ -219,22 +220,26 @@ int16_t analogRead(uint8_t ch)
 }
 
 
-uint32_t RandomUInt32(uint8_t size)
+#if !defined(RANDOM_FIXED_SEED)
+/* 32 bits of noise: the two least significant bits of the fastest reads
+   of the temperature sensor, folded twice */
+static uint32_t random_noise(void)
 {
-  uint32_t val=0, temp_val=0;
+  uint32_t val=0;
+  uint8_t nreads_prev = nreads;
 
-  analogReadConfig(0,1); /* fastest readout, no averaging */
+  nreads = 1; /* no averaging */
 
-  for (uint8_t k=0; k<4; k++)
+  for (uint8_t k=0; k<2; k++)
   {
-    temp_val = 0;
-    for (uint8_t i=0; i<(size>>1); i++)
+    for (uint8_t i=0; i<16; i++)
     {
       /* Two LS bits are most likely most random */
-      temp_val |= (analogRead(0x10) & 0x00000003) << (2*i);
+      val ^= (analogRead(0x10) & 0x00000003) << (2*i);
     }
-    val ^= temp_val;
   }
+  nreads = nreads_prev;
+
   #if defined(CRC_SALT_I)
   val = HAL_CRC_Accumulate(&hcrc, &val, 1);
   /* Add salt */
@@ -243,7 +248,82 @@ uint32_t RandomUInt32(uint8_t size)
   #endif
   return val;
 }
+#endif
 
 #endif /* #if defined(USE_STM32F0XX_NUCLEO) || defined(USE_STM32F4XX_NUCLEO) || defined(USE_STM32F0XX_DISCOVERY) */
 
- 
+
+#if !defined(USE_STM32F0XX_NUCLEO) && !defined(USE_STM32F4XX_NUCLEO) && !defined(USE_STM32F0XX_DISCOVERY)
+  #if !defined(RANDOM_FIXED_SEED)
+    #define RANDOM_FIXED_SEED 0x2545F491
+  #endif
+#endif
+
+static uint32_t random_state[4];
+static RANDOM_COUNT_TYPE random_count;
+
+static inline uint32_t random_rotl(uint32_t x, uint8_t k)
+{
+  return (x << k) | (x >> (32 - k));
+}
+
+/* splitmix32 spreads one 32 bit seed over the four words of the state */
+static uint32_t random_splitmix(uint32_t *z)
+{
+  uint32_t x = (*z += 0x9E3779B9);
+  x = (x ^ (x >> 16)) * 0x85EBCA6B;
+  x = (x ^ (x >> 13)) * 0xC2B2AE35;
+  return x ^ (x >> 16);
+}
+
+/* seed 0 takes the seed from the noise (or RANDOM_FIXED_SEED) */
+void RandomSeed(uint32_t seed)
+{
+  uint32_t z = seed;
+
+#if defined(RANDOM_FIXED_SEED)
+  if (!seed)
+    z = RANDOM_FIXED_SEED;
+#endif
+
+  for (uint8_t i=0; i<4; i++)
+  {
+    random_state[i] = random_splitmix(&z);
+#if !defined(RANDOM_FIXED_SEED)
+    if (!seed)
+      random_state[i] ^= random_noise();
+#endif
+  }
+
+  /* all zero state would only ever produce zeros */
+  if (!(random_state[0] | random_state[1] | random_state[2] | random_state[3]))
+    random_state[0] = 1;
+
+  random_count = 0;
+}
+
+/* 'size' random bits, 1 to 32, in the lowest bits of the result */
+uint32_t RandomUInt32(uint8_t size)
+{
+  uint32_t val, t;
+
+  if (!(random_state[0] | random_state[1] | random_state[2] | random_state[3]))
+    RandomSeed(0);
+#if !defined(RANDOM_FIXED_SEED)
+  else if (!(++random_count & (((RANDOM_COUNT_TYPE) 1 << RANDOM_RESEED_BITS) - 1)))
+    random_state[0] ^= random_noise();
+#endif
+
+  /* xoshiro128** by Blackman and Vigna: multiplications by 5 and 9 are
+     shifts and adds on Cortex M0 */
+  val = random_rotl(random_state[1] * 5, 7) * 9;
+  t = random_state[1] << 9;
+  random_state[2] ^= random_state[0];
+  random_state[3] ^= random_state[1];
+  random_state[1] ^= random_state[2];
+  random_state[0] ^= random_state[3];
+  random_state[2] ^= t;
+  random_state[3] = random_rotl(random_state[3], 11);
+
+  return (size < 32) ? (val >> (32 - size)) : val;
+}
@@ -6,5 +6,6 @@ void MX_CRC_Init(void);
 void      analogReadConfig(uint8_t sampletime, uint8_t nreads);
 int16_t   analogRead(uint8_t channel);
 uint32_t  RandomUInt32(uint8_t size);
+void      RandomSeed(uint32_t seed);
 
 #endif
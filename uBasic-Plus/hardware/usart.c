@@ -188,25 +188,24 @@ uint8_t serial_input_available(void)
   return n;
 }
 
-uint8_t serial_input (char * buffer, uint8_t len)
+// stores at most len characters and the terminating '\0': buffer has to
+// hold len+1 characters
+uint16_t serial_input (char * buffer, uint16_t len)
 {
-  uint8_t n = serial_input_available();
-  if (!n)
+  uint16_t i = 0;
+
+  if (!serial_input_available())
     return 0;
 
-  uint16_t i = 0;
-  while (HAL_UART_Cir_Available_IT(&huart2))
+  while ((i<len) && HAL_UART_Cir_Available_IT(&huart2))
   {
     buffer[i] = HAL_UART_Cir_RetrieveReceivedChar_IT(&huart2);
     i++;
-
-    if (i==len)
-      break;
   }
 
-  while (buffer[i-1]=='\n')
+  while ((i>0) && (buffer[i-1]=='\n'))
     i--;
-  while (buffer[i-1]=='\r')
+  while ((i>0) && (buffer[i-1]=='\r'))
     i--;
   buffer[i] = '\0';
 
@@ -71,7 +71,7 @@ void print_serial_n(char * msg, uint16_t n);
 void print_numbered_lines(char * script);
 
 uint8_t serial_input_available(void);
-uint8_t serial_input (char * buffer, uint8_t len);
+uint16_t serial_input (char * buffer, uint16_t len);
 
 #ifdef __cplusplus
 }
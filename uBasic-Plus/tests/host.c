@@ -0,0 +1,94 @@
+/*-
+ * Copyright (c) 2017-18, Marijan Kostrun <mkostrun@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * What the board code provides to the interpreter, for the host tests:
+ * print goes to stdout, unless a test expects error messages and sets
+ * host_quiet, FLASH is kept in RAM, and the pins, timers and
+ * analog inputs do nothing. Random numbers come from hardware/random.c,
+ * which starts from RANDOM_FIXED_SEED without a board.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "config.h"
+#include "ubasic.h"
+
+volatile uint32_t ubasic_script_sleeping_ms;
+volatile uint32_t ubasic_script_tic0_ms, ubasic_script_tic1_ms, ubasic_script_tic2_ms;
+volatile uint32_t ubasic_script_tic3_ms, ubasic_script_tic4_ms, ubasic_script_tic5_ms;
+volatile uint32_t ubasic_script_wait_for_input_ms;
+uint8_t ubasic_script_wait_for_input_expired;
+volatile uint8_t hw_event;
+int16_t dutycycle_pwm_ch[UBASIC_SCRIPT_HAVE_PWM_CHANNELS];
+uint8_t host_quiet;
+
+void print_serial(char * msg)
+{
+  if (!host_quiet)
+    fputs(msg, stdout);
+}
+
+uint8_t serial_input_available()
+{
+  return 1;
+}
+
+uint16_t serial_input(char * buffer, uint16_t len)
+{
+  buffer[0] = '\0';
+  return 0;
+}
+
+void analogWriteConfig(uint16_t psc, uint16_t per) { }
+void analogWrite(uint8_t ch, int16_t dutycycle) { }
+void analogReadConfig(uint8_t sampletime, uint8_t nreads) { }
+int16_t analogRead(uint8_t channel) { return 0; }
+void pinMode(uint8_t ch, int8_t mode, uint8_t freq) { }
+int8_t digitalWrite(uint8_t ch, uint8_t PinState) { return 0; }
+int8_t digitalRead(uint8_t ch) { return 0; }
+
+/* one record per name and type, as EE_WriteVariable() keeps them */
+static uint8_t ee_data[4][MAX_VARNUM][255];
+static uint8_t ee_len[4][MAX_VARNUM];
+
+void EE_Init(void) { }
+void EE_DumpFlash(void) { }
+
+void EE_WriteVariable(uint8_t Name, uint8_t Vartype, uint8_t datalen_bytes, uint8_t *dataptr)
+{
+  // arrays are either plain (2) or with header (3), not both
+  if (Vartype >= 2)
+    ee_len[5 - Vartype][Name] = 0;
+  memcpy(ee_data[Vartype][Name], dataptr, datalen_bytes);
+  ee_len[Vartype][Name] = datalen_bytes;
+}
+
+void EE_ReadVariable(uint8_t Name, uint8_t Vartype, uint8_t *dataptr, uint8_t *datalen)
+{
+  memcpy(dataptr, ee_data[Vartype][Name], ee_len[Vartype][Name]);
+  *datalen = ee_len[Vartype][Name];
+}
@@ -0,0 +1,96 @@
+/*-
+ * Copyright (c) 2017-18, Marijan Kostrun <mkostrun@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Shared by the host tests: repeatable operands, timing and the pass/fail
+ * bookkeeping. Every test prints one line per check and returns non-zero
+ * from main() if any check failed.
+ */
+
+#ifndef __TEST_H__
+#define __TEST_H__
+
+#include <stdio.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+static int test_failed;
+
+/* results of timed loops end up here, so that they are not optimized away */
+static volatile uint64_t test_sink;
+
+/* xorshift64: the same operands on every run */
+static uint64_t test_seed = 0x9e3779b97f4a7c15ull;
+
+static inline uint64_t test_rand(void)
+{
+  test_seed ^= test_seed << 13;
+  test_seed ^= test_seed >> 7;
+  test_seed ^= test_seed << 17;
+  return test_seed;
+}
+
+/* random number of random length: all magnitudes get tested alike */
+static inline uint64_t test_rand_bits(void)
+{
+  uint64_t r = test_rand();
+  return r >> (test_rand() & 63);
+}
+
+/* the same with a random sign, wrapped to the bits the caller keeps */
+static inline uint64_t test_rand_signed(void)
+{
+  uint64_t r = test_rand_bits();
+  return (test_rand() & 1) ? -r : r;
+}
+
+static inline double test_ns(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/* one line per check: what, the largest error found and its bound */
+static void test_report(const char *what, double err, double bound)
+{
+  uint8_t ok = (err <= bound);
+  printf("%-32s %12.4g  (max %g)  %s\n", what, err, bound, ok ? "ok" : "FAILED");
+  if (!ok)
+    test_failed = 1;
+}
+
+/* and one per timed loop: host times only compare variants on the host */
+static void test_timing(const char *what, double t0, uint32_t n)
+{
+  printf("%-32s %12.1f ns\n", what, (test_ns() - t0) / n);
+}
+
+#endif /* __TEST_H__ */
@@ -0,0 +1,526 @@
+/*-
+ * Copyright (c) 2017-18, Marijan Kostrun <mkostrun@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * The bulk array statements and functions, run through the interpreter as
+ * a script would, on plain and packed arrays of random sizes: asum, amin,
+ * amax, amean, amedian and adot, afill and acopy, asort and afind, push
+ * and pop on ring arrays, and matmul, matvec and mattrans. The reference
+ * keeps every array as a C array of the values as they are stored, and
+ * computes in exact integer arithmetic what the README promises: sums and
+ * products taken exactly, rounded down once and saturated at the end, so
+ * every result has to match to the lsb.
+ */
+
+#include <stdarg.h>
+#include "test.h"
+#include "ubasic.h"
+
+#define VAR(c)        ((c) - 'a')
+#define FBITS         FIXEDPT_FBITS
+#define VBITS         (8 * (int) sizeof(VARIABLE_TYPE))
+#define MAX_N         300
+
+typedef __int128 wide_t;
+
+extern volatile _Status ubasic_status;
+
+/* host.c: no error messages while the test provokes errors */
+extern uint8_t host_quiet;
+
+static const char *type_name[] = { "plain", "int8", "uint8", "int16" };
+
+/* what the model keeps: the elements as they are stored */
+static int64_t model_x[MAX_N], model_y[MAX_N];
+
+/* the statement, with printf formatting: returns 1 if it stopped with an
+   error */
+static uint8_t run(const char *fmt, ...)
+{
+  static char stmt[80];
+  va_list ap;
+
+  va_start(ap, fmt);
+  vsnprintf(stmt, sizeof(stmt), fmt, ap);
+  va_end(ap);
+  ubasic_execute_statement(stmt);
+  return ubasic_status.bit.Error;
+}
+
+/* random value of up to bits bits and either sign */
+static int64_t rand_value(int bits)
+{
+  int64_t r = (int64_t) (test_rand_bits() >> (64 - bits));
+  return (test_rand() & 1) ? -r : r;
+}
+
+static int64_t saturate(wide_t s)
+{
+  if (s > VARIABLE_TYPE_MAX)
+    return VARIABLE_TYPE_MAX;
+  if (s < -VARIABLE_TYPE_MAX)
+    return -VARIABLE_TYPE_MAX;
+  return (int64_t) s;
+}
+
+/* a value as a packed array keeps it: the integer part, rounded down and
+   saturated to the type */
+static int64_t keep(uint8_t type, int64_t v)
+{
+  static const int64_t lo[] = { 0, -128, 0, -32768 }, hi[] = { 0, 127, 255, 32767 };
+
+  if (type == ARRAY_TYPE_VARIABLE)
+    return v;
+  v >>= FBITS;
+  return (v < lo[type]) ? lo[type] : (v > hi[type]) ? hi[type] : v;
+}
+
+static int64_t value(uint8_t type, int64_t k)
+{
+  return (type == ARRAY_TYPE_VARIABLE) ? k : k * ((int64_t) 1 << FBITS);
+}
+
+/* a random value to store in an array of the type, now and then one the
+   packed types have to saturate */
+static int64_t rand_element(uint8_t type, int bits)
+{
+  if (type == ARRAY_TYPE_VARIABLE)
+    return rand_value(bits);
+  return rand_value(FBITS + ((test_rand() & 7) ? 15 : 17));
+}
+
+static void dim_random(char c, uint8_t type, uint16_t n, int64_t *model, int bits)
+{
+  uint16_t i;
+
+  ubasic_dim_typedarrayvariable(VAR(c), n, 0, type);
+  for (i = 0; i < n; i++)
+  {
+    int64_t v = rand_element(type, bits);
+    ubasic_set_arrayvariable(VAR(c), i + 1, (VARIABLE_TYPE) v);
+    model[i] = keep(type, v);
+  }
+}
+
+/* elements of array c that differ from the model */
+static uint32_t array_errors(char c, uint8_t type, const int64_t *model, uint16_t n)
+{
+  uint32_t err = 0;
+  uint16_t i;
+
+  for (i = 0; i < n; i++)
+    if (ubasic_get_arrayvariable(VAR(c), i + 1) != value(type, model[i]))
+      err++;
+  return err;
+}
+
+static int cmp_value(const void *a, const void *b)
+{
+  int64_t x = *(const int64_t *) a, y = *(const int64_t *) b;
+  return (x > y) - (x < y);
+}
+
+static double lsb(int64_t a, int64_t b)
+{
+  return fabs((double) a - (double) b);
+}
+
+/*---------------------------------------------------------------------------*/
+static void test_reductions(void)
+{
+  double e_sum = 0, e_mean = 0, e_minmax = 0, e_median = 0, e_dot = 0;
+  int64_t v[MAX_N];
+  uint16_t nx, ny, i, k;
+  uint8_t tx, ty;
+  wide_t s, d;
+  char what[40];
+  double t;
+
+  for (k = 0; k < 2000; k++)
+  {
+    tx = test_rand() & 3;
+    ty = test_rand() & 3;
+    nx = 1 + test_rand() % 200;
+    ny = 1 + test_rand() % 200;
+    /* small enough that the products of adot fit the accumulator */
+    dim_random('x', tx, nx, model_x, VBITS - 6);
+    dim_random('y', ty, ny, model_y, VBITS - 6);
+
+    s = d = 0;
+    for (i = 0; i < nx; i++)
+    {
+      v[i] = value(tx, model_x[i]);
+      s += v[i];
+      if (i < ny)
+        d += (wide_t) v[i] * value(ty, model_y[i]);
+    }
+    qsort(v, nx, sizeof(v[0]), cmp_value);
+
+    run("s = asum(x@)");
+    e_sum = fmax(e_sum, lsb(ubasic_get_variable(VAR('s')), saturate(s)));
+    run("s = amean(x@)");
+    e_mean = fmax(e_mean, lsb(ubasic_get_variable(VAR('s')), saturate(s / nx)));
+    run("s = amin(x@)");
+    e_minmax = fmax(e_minmax, lsb(ubasic_get_variable(VAR('s')), v[0]));
+    run("s = amax(x@)");
+    e_minmax = fmax(e_minmax, lsb(ubasic_get_variable(VAR('s')), v[nx - 1]));
+    run("s = amedian(x@)");
+    s = (nx & 1) ? v[nx/2] : ((wide_t) v[nx/2 - 1] + v[nx/2]) / 2;
+    e_median = fmax(e_median, lsb(ubasic_get_variable(VAR('s')), (int64_t) s));
+    run("s = adot(x@, y@)");
+    e_dot = fmax(e_dot, lsb(ubasic_get_variable(VAR('s')), saturate(d >> FBITS)));
+  }
+  test_report("asum, lsb", e_sum, 0);
+  test_report("amean, lsb", e_mean, 0);
+  test_report("amin, amax, lsb", e_minmax, 0);
+  test_report("amedian, lsb", e_median, 0);
+  test_report("adot, lsb", e_dot, 0);
+
+  for (tx = 0; tx < 4; tx += 3)
+  {
+    dim_random('x', tx, 200, model_x, VBITS - 6);
+    dim_random('y', tx, 200, model_y, VBITS - 6);
+    t = test_ns();
+    for (k = 0; k < 1000; k++)
+      run("s = adot(x@, y@)");
+    sprintf(what, "adot of 200, %s", type_name[tx]);
+    test_timing(what, t, 1000);
+  }
+}
+
+/*---------------------------------------------------------------------------*/
+static void test_fill_copy(void)
+{
+  uint32_t e_fill = 0, e_copy = 0, e_range = 0;
+  int64_t v, tmp[MAX_N], *src, *dst;
+  int32_t s, t, n, ns, nt;
+  uint16_t k, i;
+  uint8_t tx, ty, nargs, same, err;
+  char stmt[60];
+
+  for (k = 0; k < 2000; k++)
+  {
+    tx = test_rand() & 3;
+    nt = 1 + test_rand() % 200;
+    dim_random('x', tx, nt, model_x, VBITS - 2);
+    v = rand_element(tx, VBITS - 2);
+    ubasic_set_variable(VAR('v'), (VARIABLE_TYPE) v);
+    run("afill x@, v");
+    for (i = 0; i < nt; i++)
+      model_x[i] = keep(tx, v);
+    e_fill += array_errors('x', tx, model_x, nt);
+  }
+  test_report("afill, wrong elements", e_fill, 0);
+
+  for (k = 0; k < 5000; k++)
+  {
+    tx = test_rand() & 3;
+    ty = test_rand() & 3;
+    same = (test_rand() % 3 == 0);
+    ns = 1 + test_rand() % 100;
+    dim_random('x', tx, ns, model_x, VBITS - 2);
+    src = model_x;
+    if (same)
+    {
+      ty = tx;
+      nt = ns;
+      dst = model_x;
+    }
+    else
+    {
+      nt = 1 + test_rand() % 100;
+      dim_random('y', ty, nt, model_y, VBITS - 2);
+      dst = model_y;
+    }
+
+    /* now and then a range that does not fit */
+    s = 1 + test_rand() % (ns + 1);
+    t = 1 + test_rand() % (nt + 1);
+    n = -1;
+    nargs = test_rand() & 3;
+    if (nargs == 3)
+      n = test_rand() % (ns + 2);
+    if (nargs < 2)
+      t = 1;
+    if (nargs < 1)
+      s = 1;
+
+    strcpy(stmt, (same) ? "acopy x@, x@" : "acopy y@, x@");
+    if (nargs >= 1)
+      sprintf(stmt + strlen(stmt), ", %d", s);
+    if (nargs >= 2)
+      sprintf(stmt + strlen(stmt), ", %d", t);
+    if (nargs >= 3)
+      sprintf(stmt + strlen(stmt), ", %d", n);
+    err = run("%s", stmt);
+
+    if (n < 0)
+      n = (ns - s + 1 < nt - t + 1) ? ns - s + 1 : nt - t + 1;
+    if ( (n < 0) || (s + n - 1 > ns) || (t + n - 1 > nt) )
+    {
+      /* an error, and the arrays stay as they were */
+      e_range += !err;
+      n = 0;
+    }
+    else
+      e_range += err;
+
+    for (i = 0; i < n; i++)
+      tmp[i] = value(tx, src[s - 1 + i]);
+    for (i = 0; i < n; i++)
+      dst[t - 1 + i] = keep(ty, tmp[i]);
+    e_copy += array_errors((same) ? 'x' : 'y', ty, dst, nt);
+  }
+  test_report("acopy, wrong elements", e_copy, 0);
+  test_report("acopy, wrong range errors", e_range, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+static void test_sort_find(void)
+{
+  uint32_t e_sort = 0, e_find = 0;
+  int64_t v, few[4];
+  uint16_t n, k, i, j, cnt;
+  uint8_t tx, desc;
+  double t;
+
+  for (k = 0; k < 1000; k++)
+  {
+    tx = test_rand() & 3;
+    n = 1 + test_rand() % MAX_N;
+    dim_random('x', tx, n, model_x, VBITS - 2);
+    /* half of the arrays are made of a few values repeated */
+    if (test_rand() & 1)
+    {
+      for (j = 0; j < 4; j++)
+        few[j] = rand_element(tx, VBITS - 2);
+      for (i = 0; i < n; i++)
+      {
+        v = few[test_rand() & 3];
+        ubasic_set_arrayvariable(VAR('x'), i + 1, (VARIABLE_TYPE) v);
+        model_x[i] = keep(tx, v);
+      }
+    }
+
+    desc = test_rand() & 1;
+    run((desc) ? "asort x@, desc" : "asort x@");
+    qsort(model_x, n, sizeof(model_x[0]), cmp_value);
+    if (desc)
+      for (i = 0; i < n/2; i++)
+      {
+        v = model_x[i];
+        model_x[i] = model_x[n - 1 - i];
+        model_x[n - 1 - i] = v;
+      }
+    e_sort += array_errors('x', tx, model_x, n);
+
+    if (desc)
+      continue;
+    for (j = 0; j < 20; j++)
+    {
+      /* the elements themselves and the values around them */
+      v = value(tx, model_x[test_rand() % n]);
+      if (j & 1)
+        v += rand_value((tx == ARRAY_TYPE_VARIABLE) ? VBITS - 8 : FBITS + 2);
+      ubasic_set_variable(VAR('v'), (VARIABLE_TYPE) v);
+      run("r = afind(x@, v)");
+      for (cnt = 0; (cnt < n) && (value(tx, model_x[cnt]) <= v); cnt++)
+        ;
+      e_find += (ubasic_get_variable(VAR('r')) != value(ARRAY_TYPE_INT16, cnt));
+    }
+  }
+  test_report("asort, wrong elements", e_sort, 0);
+  test_report("afind, wrong indices", e_find, 0);
+
+  dim_random('x', ARRAY_TYPE_VARIABLE, MAX_N, model_x, VBITS - 2);
+  t = test_ns();
+  for (k = 0; k < 200; k++)
+  {
+    run("asort x@");
+    run("asort x@, desc");
+  }
+  test_timing("asort of 300, both ways", t, 400);
+}
+
+/*---------------------------------------------------------------------------*/
+// the model ring keeps the newest element first
+static void test_ring(void)
+{
+  uint32_t e_ring = 0, e_pop = 0, e_sum = 0;
+  int64_t v;
+  uint16_t n, k, i, j, count;
+  uint8_t tx;
+  wide_t s;
+
+  for (k = 0; k < 200; k++)
+  {
+    tx = test_rand() & 3;
+    n = 1 + test_rand() % 50;
+    ubasic_dim_typedarrayvariable(VAR('r'), n, 0, tx | ARRAY_TYPE_RING);
+    count = 0;
+
+    for (j = 0; j < 500; j++)
+    {
+      if (test_rand() % 3)
+      {
+        v = rand_element(tx, VBITS - 8);
+        ubasic_set_variable(VAR('v'), (VARIABLE_TYPE) v);
+        run("push r@, v");
+        memmove(model_x + 1, model_x, n * sizeof(model_x[0]));
+        model_x[0] = keep(tx, v);
+        if (count < n)
+          count++;
+      }
+      else
+      {
+        run("p = pop(r@)");
+        v = 0;
+        if (count)
+          v = value(tx, model_x[--count]);
+        e_pop += (ubasic_get_variable(VAR('p')) != v);
+      }
+      e_ring += array_errors('r', tx, model_x, count);
+
+      /* the reductions see only the elements pushed so far */
+      run("s = asum(r@)");
+      for (s = 0, i = 0; i < count; i++)
+        s += value(tx, model_x[i]);
+      e_sum += (ubasic_get_variable(VAR('s')) != saturate(s));
+    }
+
+    /* afill fills the ring up completely */
+    v = rand_element(tx, VBITS - 8);
+    ubasic_set_variable(VAR('v'), (VARIABLE_TYPE) v);
+    run("afill r@, v");
+    for (j = 0; j < n; j++)
+      model_x[j] = keep(tx, v);
+    e_ring += array_errors('r', tx, model_x, n);
+    run("s = asum(r@)");
+    e_sum += (ubasic_get_variable(VAR('s')) != saturate((wide_t) n * value(tx, keep(tx, v))));
+  }
+  test_report("push, wrong elements", e_ring, 0);
+  test_report("pop, wrong values", e_pop, 0);
+  test_report("asum of rings, wrong sums", e_sum, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+static void test_matrix(void)
+{
+  uint32_t e_mul = 0, e_vec = 0, e_trans = 0, e_shape = 0;
+  uint16_t rows, cols, m, i, j, k, it;
+  wide_t s;
+  double t;
+
+  for (it = 0; it < 1000; it++)
+  {
+    /* the unrolled sizes 3 and 4 a good part of the time */
+    rows = 1 + test_rand() % 8;
+    cols = (test_rand() & 1) ? 3 + (test_rand() & 1) : 1 + test_rand() % 8;
+    m = 1 + test_rand() % 8;
+
+    dim_random('x', ARRAY_TYPE_VARIABLE, rows * cols, model_x, VBITS - 6);
+    ubasic_dim_arrayvariable_2d(VAR('x'), rows, cols);
+    dim_random('y', ARRAY_TYPE_VARIABLE, cols * m, model_y, VBITS - 6);
+    ubasic_dim_arrayvariable_2d(VAR('y'), cols, m);
+
+    e_shape += run("matmul z@, x@, y@");
+    for (i = 0; i < rows; i++)
+      for (j = 0; j < m; j++)
+      {
+        for (s = 0, k = 0; k < cols; k++)
+          s += (wide_t) model_x[i*cols + k] * model_y[k*m + j];
+        e_mul += (ubasic_get_arrayvariable(VAR('z'), i*m + j + 1) != saturate(s >> FBITS));
+      }
+
+    /* the first column of y@ as a vector */
+    ubasic_dim_arrayvariable(VAR('v'), cols);
+    for (k = 0; k < cols; k++)
+      ubasic_set_arrayvariable(VAR('v'), k + 1, (VARIABLE_TYPE) model_y[k*m]);
+    e_shape += run("matvec w@, x@, v@");
+    for (i = 0; i < rows; i++)
+    {
+      for (s = 0, k = 0; k < cols; k++)
+        s += (wide_t) model_x[i*cols + k] * model_y[k*m];
+      e_vec += (ubasic_get_arrayvariable(VAR('w'), i + 1) != saturate(s >> FBITS));
+    }
+
+    e_shape += run("mattrans t@, x@");
+    for (i = 0; i < rows; i++)
+      for (j = 0; j < cols; j++)
+        e_trans += (ubasic_get_arrayvariable(VAR('t'), j*rows + i + 1) != model_x[i*cols + j]);
+
+    /* in place, which only a square matrix can be */
+    ubasic_dim_arrayvariable_2d(VAR('x'), rows, rows);
+    for (i = 0; i < rows * rows; i++)
+      ubasic_set_arrayvariable(VAR('x'), i + 1, (VARIABLE_TYPE) model_x[i]);
+    e_shape += run("mattrans x@, x@");
+    for (i = 0; i < rows; i++)
+      for (j = 0; j < rows; j++)
+        e_trans += (ubasic_get_arrayvariable(VAR('x'), j*rows + i + 1) != model_x[i*rows + j]);
+
+    /* shapes that do not fit: x@ is rows x rows by now */
+    ubasic_dim_arrayvariable_2d(VAR('y'), rows + 1, m);
+    e_shape += !run("matmul z@, x@, y@") + !run("matmul x@, x@, x@");
+    if (rows != cols)
+    {
+      ubasic_dim_arrayvariable_2d(VAR('x'), rows, cols);
+      e_shape += !run("mattrans x@, x@");
+    }
+  }
+  test_report("matmul, wrong elements", e_mul, 0);
+  test_report("matvec, wrong elements", e_vec, 0);
+  test_report("mattrans, wrong elements", e_trans, 0);
+  test_report("matrix shapes, wrong errors", e_shape, 0);
+
+  for (cols = 3; cols <= 8; cols += 5)
+  {
+    char what[40];
+    dim_random('x', ARRAY_TYPE_VARIABLE, cols * cols, model_x, VBITS - 6);
+    ubasic_dim_arrayvariable_2d(VAR('x'), cols, cols);
+    dim_random('y', ARRAY_TYPE_VARIABLE, cols * cols, model_y, VBITS - 6);
+    ubasic_dim_arrayvariable_2d(VAR('y'), cols, cols);
+    t = test_ns();
+    for (k = 0; k < 1000; k++)
+      run("matmul z@, x@, y@");
+    sprintf(what, "matmul %dx%d", cols, cols);
+    test_timing(what, t, 1000);
+  }
+}
+
+int main(void)
+{
+  printf("arrays, %d.%d\n", FIXEDPT_WBITS, FIXEDPT_FBITS);
+  ubasic_clear_variables();
+  host_quiet = 1;
+
+  test_reductions();
+  test_fill_copy();
+  test_sort_find();
+  test_ring();
+  test_matrix();
+
+  return test_failed;
+}
@@ -0,0 +1,93 @@
+/*-
+ * Copyright (c) 2017-18, Marijan Kostrun <mkostrun@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * fixedpt_div with FIXEDPT_DIV_32 against the double width division it
+ * replaces: the quotients have to be the same, truncated towards zero and
+ * wrapped to fixedpt, for random operands of random magnitude and sign
+ * and for every pair of edge values.
+ */
+
+#include "test.h"
+#include "fixedptc.h"
+
+#define DIV_RANDOM  4000000
+
+/* the division without FIXEDPT_DIV_32 */
+static fixedpt div_double(fixedpt A, fixedpt B)
+{
+  return (fixedpt) (((fixedptd) A * ((fixedptd) 1 << FIXEDPT_FBITS)) / B);
+}
+
+static const fixedpt div_edges[] = {
+  0, 1, -1, 2, -2, FIXEDPT_ONE_HALF, -FIXEDPT_ONE_HALF, FIXEDPT_ONE - 1,
+  FIXEDPT_ONE, -FIXEDPT_ONE, FIXEDPT_ONE + 1, FIXEDPT_TWO, -FIXEDPT_TWO,
+  FIXEDPT_PI, -FIXEDPT_PI, FIXEDPT_FMASK, -FIXEDPT_FMASK,
+  (fixedpt) ((fixedptu) -1 >> 1), -(fixedpt) ((fixedptu) -1 >> 1) - 1,
+  (fixedpt) ((fixedptu) -1 >> 1) - 1, -(fixedpt) ((fixedptu) -1 >> 1),
+  (fixedpt) ((fixedptu) -1 >> 2), -(fixedpt) ((fixedptu) -1 >> 2)
+};
+
+#define DIV_EDGES  (sizeof(div_edges) / sizeof(div_edges[0]))
+
+int main(void)
+{
+  static fixedpt a[DIV_RANDOM], b[DIV_RANDOM];
+  uint32_t i, j, bad = 0;
+  fixedpt s = 0;
+  double t;
+
+  printf("div, %d.%d\n", FIXEDPT_WBITS, FIXEDPT_FBITS);
+
+  for (i = 0; i < DIV_EDGES; i++)
+    for (j = 0; j < DIV_EDGES; j++)
+      if (div_edges[j])
+        bad += (fixedpt_div(div_edges[i], div_edges[j]) != div_double(div_edges[i], div_edges[j]));
+  test_report("edges, mismatches", bad, 0);
+
+  for (i = 0; i < DIV_RANDOM; i++)
+  {
+    a[i] = (fixedpt) test_rand_signed();
+    do
+      b[i] = (fixedpt) test_rand_signed();
+    while (b[i] == 0);
+  }
+  for (i = 0, bad = 0; i < DIV_RANDOM; i++)
+    bad += (fixedpt_div(a[i], b[i]) != div_double(a[i], b[i]));
+  test_report("random, mismatches", bad, 0);
+
+  t = test_ns();
+  for (i = 0; i < DIV_RANDOM; i++)
+    s += fixedpt_div(a[i], b[i]);
+  test_timing("fixedpt_div", t, DIV_RANDOM);
+  t = test_ns();
+  for (i = 0; i < DIV_RANDOM; i++)
+    s += div_double(a[i], b[i]);
+  test_timing("double width division", t, DIV_RANDOM);
+  test_sink = s;
+
+  return test_failed;
+}
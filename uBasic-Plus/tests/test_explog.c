@@ -0,0 +1,154 @@
+/*-
+ * Copyright (c) 2017-18, Marijan Kostrun <mkostrun@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * exp, ln and pow of fixedptc.h against libm. The Q30 kernels are good to
+ * about 2^-26 of the result, or of 1 for results below 1, which shows in
+ * the 32 fraction bits of 32.32; what is left over that has to be within
+ * the rounding of the last bit. pow(x, 3) multiplies x by the rounded x^2,
+ * which leaves |x|/2 lsb instead. exp runs over every input up to the top
+ * of its range (evenly spaced ones in 32.32), the others over random
+ * operands of random magnitude whose results are in range. exp has to
+ * saturate on either side of its range.
+ */
+
+#include "test.h"
+#include "fixedptc.h"
+
+#define EXPLOG_RANDOM 2000000
+#define EXPLOG_REL    (1.0 / (1 << 26))
+
+static fixedpt fixedpt_max = (fixedpt) ((fixedptu) -1 >> 1);
+
+static double explog_err;
+
+/* error in lsb beyond the slack, in lsb too: long double holds 32.32 */
+static void explog_check(fixedpt v, long double ref, double slack)
+{
+  double err = fabsl((long double) v - ldexpl(ref, FIXEDPT_FBITS)) - slack;
+  if (err > explog_err)
+    explog_err = err;
+}
+
+/* EXPLOG_REL of the result in lsb */
+static double explog_rel(double ref)
+{
+  return ldexp(EXPLOG_REL * fmax(fabs(ref), 1), FIXEDPT_FBITS);
+}
+
+static void explog_report(const char *what, double bound)
+{
+  test_report(what, explog_err, bound);
+  explog_err = 0;
+}
+
+/* positive operand of random magnitude */
+static fixedpt explog_rand(void)
+{
+  fixedpt a = (fixedpt) (test_rand() >> (65 - FIXEDPT_BITS + test_rand() % (FIXEDPT_BITS - 1)));
+  return (a) ? a : 1;
+}
+
+static double explog_double(fixedpt a)
+{
+  return ldexp((double) a, -FIXEDPT_FBITS);
+}
+
+int main(void)
+{
+  /* exp is in range from -(FBITS + 1) ln 2 to (WBITS - 1) ln 2 */
+  fixedpt first = -fixedpt_rconst((FIXEDPT_FBITS + 1) * M_LN2);
+  fixedpt last = fixedpt_rconst((FIXEDPT_WBITS - 1) * M_LN2) - 1;
+  fixedpt step = ((last - first) >> 22) ? ((last - first) >> 22) : 1;
+  double top = ldexp((double) fixedpt_max, -FIXEDPT_FBITS), ref;
+  fixedpt a, three = fixedpt_fromint(3), one_half = fixedpt_rconst(1.5), s = 0;
+  uint32_t i, n, sat = 0;
+  double t;
+
+  printf("exp, ln and pow, %d.%d\n", FIXEDPT_WBITS, FIXEDPT_FBITS);
+
+  for (a = first; a <= last; a += step)
+  {
+    ref = fmin(exp(explog_double(a)), top);
+    explog_check(fixedpt_exp(a), ref, explog_rel(ref));
+  }
+  explog_report("exp, lsb over 2^-26", 1);
+
+  for (i = 0; i < 1000; i++)
+  {
+    a = last + 1 + (fixedpt) (test_rand() % (fixedpt_max - last));
+    sat += (fixedpt_exp(a) != fixedpt_max);
+    a = first - 1 - (fixedpt) (test_rand() % (fixedpt_max + first));
+    sat += (fixedpt_exp(a) > 1);
+  }
+  test_report("exp saturated, mismatches", sat, 0);
+
+  for (i = 0; i < EXPLOG_RANDOM; i++)
+  {
+    a = explog_rand();
+    ref = log(explog_double(a));
+    explog_check(fixedpt_ln(a), ref, explog_rel(ref));
+  }
+  explog_report("ln, lsb over 2^-26", 0.5);
+
+  for (i = 0; i < EXPLOG_RANDOM; i++)
+  {
+    a = explog_rand() >> ((FIXEDPT_WBITS - 1) * 2 / 3 + 1);
+    if (test_rand() & 1)
+      a = -a;
+    explog_check(fixedpt_pow(a, three), powl(explog_double(a), 3),
+                 fabs(explog_double(a)) / 2);
+  }
+  explog_report("pow(x, 3), lsb over |x|/2", 0.5);
+
+  for (i = 0; i < EXPLOG_RANDOM; i++)
+  {
+    a = explog_rand() >> ((FIXEDPT_WBITS - 1) / 3 + 1);
+    ref = pow(explog_double(a), 1.5);
+    explog_check(fixedpt_pow(a, one_half), ref, explog_rel(ref));
+  }
+  explog_report("pow(x, 1.5), lsb over 2^-26", 1);
+
+  t = test_ns();
+  for (a = first, n = 0; a <= last; a += step, n++)
+    s += fixedpt_exp(a);
+  test_timing("exp", t, n);
+  t = test_ns();
+  for (i = 0; i < n; i++)
+    s += fixedpt_ln(i + 1);
+  test_timing("ln", t, n);
+  t = test_ns();
+  for (i = 0; i < n; i++)
+    s += fixedpt_pow(i, three);
+  test_timing("pow(x, 3)", t, n);
+  t = test_ns();
+  for (i = 0; i < n; i++)
+    s += fixedpt_pow(i + 1, one_half);
+  test_timing("pow(x, 1.5)", t, n);
+  test_sink = s;
+
+  return test_failed;
+}
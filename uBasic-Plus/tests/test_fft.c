@@ -0,0 +1,192 @@
+/*-
+ * Copyright (c) 2017-18, Marijan Kostrun <mkostrun@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * fft and amag against a double precision reference, run through the
+ * interpreter as a script would: random and single tone inputs of every
+ * size from 2 to 1024 points. fft works on the elements as they are kept,
+ * so the errors are in lsb of the element for inputs up to 2^15 lsb, where
+ * the Q15 twiddle factors are exact enough, and in 2^-15 of the range for
+ * full range inputs. The forward transform returns the spectrum divided by
+ * the size; the inverse, which does not scale, is fed spectra whose
+ * transforms stay in range. amag has to be the exact square root, rounded
+ * down, of re^2 + im^2.
+ */
+
+#include "test.h"
+#include "ubasic.h"
+
+#define FFT_MIN_BITS  1
+#define FFT_MAX_BITS  10
+
+#define VAR_RE        ('r' - 'a')
+#define VAR_IM        ('i' - 'a')
+#define VAR_MAG       ('m' - 'a')
+
+static char fft_forward[] = "fft r@, i@";
+static char fft_inverse[] = "fft r@, i@, inverse";
+static char fft_amag[]    = "amag m@, r@, i@";
+
+static double in_re[1 << FFT_MAX_BITS], in_im[1 << FFT_MAX_BITS];
+
+/* largest difference, in lsb, between the transform in r@, i@ and the
+   discrete fourier transform of in_re, in_im times scale */
+static double fft_error(uint16_t n, int8_t sign, double scale)
+{
+  double err = 0, re, im, w;
+  uint16_t j, k;
+
+  for (k = 0; k < n; k++)
+  {
+    re = im = 0;
+    for (j = 0; j < n; j++)
+    {
+      w = sign * 2 * M_PI * (double) ((uint32_t) j * k % n) / n;
+      re += in_re[j] * cos(w) - in_im[j] * sin(w);
+      im += in_re[j] * sin(w) + in_im[j] * cos(w);
+    }
+    re = fabs(re * scale - (double) ubasic_get_arrayvariable(VAR_RE, k + 1));
+    im = fabs(im * scale - (double) ubasic_get_arrayvariable(VAR_IM, k + 1));
+    if (re > err)
+      err = re;
+    if (im > err)
+      err = im;
+  }
+  return err;
+}
+
+static void fft_input(uint16_t n, uint8_t tone, double amplitude)
+{
+  uint16_t j;
+
+  ubasic_dim_arrayvariable(VAR_RE, n);
+  ubasic_dim_arrayvariable(VAR_IM, n);
+  for (j = 0; j < n; j++)
+  {
+    if (tone)
+    {
+      in_re[j] = round(amplitude * cos(2 * M_PI * j * (n / 4 + 1) / n));
+      in_im[j] = 0;
+    }
+    else
+    {
+      in_re[j] = round(amplitude * ((double) (test_rand() >> 11) / (1ull << 52) - 1));
+      in_im[j] = round(amplitude * ((double) (test_rand() >> 11) / (1ull << 52) - 1));
+    }
+    ubasic_set_arrayvariable(VAR_RE, j + 1, (VARIABLE_TYPE) in_re[j]);
+    ubasic_set_arrayvariable(VAR_IM, j + 1, (VARIABLE_TYPE) in_im[j]);
+  }
+}
+
+/* square root of x, rounded down */
+static uint64_t test_isqrt(unsigned __int128 x)
+{
+  uint64_t r = (uint64_t) sqrtl((long double) x);
+  while ((unsigned __int128) r * r > x)
+    r--;
+  while ((unsigned __int128) (r + 1) * (r + 1) <= x)
+    r++;
+  return r;
+}
+
+int main(void)
+{
+  /* inputs up to full range and up to the Q15 of the twiddle factors */
+  double full = ldexp(1, 8 * sizeof(VARIABLE_TYPE) - 2), small = ldexp(1, 15);
+  double err, err_fwd = 0, err_tone = 0, err_inv = 0, err_full = 0, err_mag = 0;
+  int64_t x, y;
+  uint16_t n, j;
+  uint8_t b;
+  char what[40];
+  double t;
+
+  printf("fft, %d.%d\n", FIXEDPT_WBITS, FIXEDPT_FBITS);
+  ubasic_clear_variables();
+
+  for (b = FFT_MIN_BITS; b <= FFT_MAX_BITS; b++)
+  {
+    n = 1 << b;
+
+    fft_input(n, 0, small);
+    ubasic_execute_statement(fft_forward);
+    err = fft_error(n, -1, 1.0 / n);
+    if (err > err_fwd)
+      err_fwd = err;
+
+    fft_input(n, 1, small);
+    ubasic_execute_statement(fft_forward);
+    err = fft_error(n, -1, 1.0 / n);
+    if (err > err_tone)
+      err_tone = err;
+
+    fft_input(n, 0, small / n);
+    ubasic_execute_statement(fft_inverse);
+    err = fft_error(n, 1, 1.0);
+    if (err > err_inv)
+      err_inv = err;
+
+    /* at full range the twiddle factors set the error: in 2^-15 of range */
+    fft_input(n, 0, full);
+    ubasic_execute_statement(fft_forward);
+    err = fft_error(n, -1, 1.0 / n) / full * small;
+    if (err > err_full)
+      err_full = err;
+    fft_input(n, 0, full / n);
+    ubasic_execute_statement(fft_inverse);
+    err = fft_error(n, 1, 1.0) / full * small;
+    if (err > err_full)
+      err_full = err;
+  }
+  test_report("forward, random, lsb", err_fwd, 4);
+  test_report("forward, tone, lsb", err_tone, 4);
+  /* the inverse does not halve, so the roundings of all stages add up */
+  sprintf(what, "inverse, %d points, lsb", 1 << FFT_MAX_BITS);
+  test_report(what, err_inv, 1 << (FFT_MAX_BITS / 2));
+  test_report("full range, 2^-15 of range", err_full, 1);
+
+  n = 1 << FFT_MAX_BITS;
+  fft_input(n, 0, full);
+  ubasic_dim_arrayvariable(VAR_MAG, n);
+  ubasic_execute_statement(fft_amag);
+  for (j = 1; j <= n; j++)
+  {
+    x = ubasic_get_arrayvariable(VAR_RE, j);
+    y = ubasic_get_arrayvariable(VAR_IM, j);
+    err = fabs((double) test_isqrt((unsigned __int128) ((__int128) x * x + (__int128) y * y))
+               - (double) ubasic_get_arrayvariable(VAR_MAG, j));
+    if (err > err_mag)
+      err_mag = err;
+  }
+  test_report("amag, lsb", err_mag, 0);
+
+  t = test_ns();
+  for (j = 0; j < 100; j++)
+    ubasic_execute_statement(fft_forward);
+  sprintf(what, "fft of %d points", n);
+  test_timing(what, t, 100);
+
+  return test_failed;
+}
@@ -0,0 +1,253 @@
+/*-
+ * Copyright (c) 2017-18, Marijan Kostrun <mkostrun@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * filter_init and filter, run through the interpreter as a script would:
+ * FIR filters of 1 to 32 taps and biquad sections with random stable
+ * poles, fed random samples. Every output has to be within 1/2 lsb of the
+ * exact sum of the products, taken in 128 bit integers, for the past
+ * inputs and, for a biquad, the past outputs the filter returned. A
+ * cascade has to give the same as its sections run one after the other.
+ */
+
+#include <stdarg.h>
+#include "test.h"
+#include "ubasic.h"
+
+#define VAR(c)        ((c) - 'a')
+#define FBITS         FIXEDPT_FBITS
+#define VBITS         (8 * (int) sizeof(VARIABLE_TYPE))
+#define MAX_TAPS      32
+#define MAX_SECTIONS  4         /* 5 coefficients each, no more than MAX_TAPS */
+#define STEPS         200
+
+typedef __int128 wide_t;
+
+extern volatile _Status ubasic_status;
+
+/* host.c: no error messages while the test provokes errors */
+extern uint8_t host_quiet;
+
+static char filter_step[] = "y = filter(f@, x)";
+
+/* the statement, with printf formatting: returns 1 if it stopped with an
+   error */
+static uint8_t run(const char *fmt, ...)
+{
+  static char stmt[80];
+  va_list ap;
+
+  va_start(ap, fmt);
+  vsnprintf(stmt, sizeof(stmt), fmt, ap);
+  va_end(ap);
+  ubasic_execute_statement(stmt);
+  return ubasic_status.bit.Error;
+}
+
+/* random value of up to bits bits and either sign */
+static int64_t rand_value(int bits)
+{
+  int64_t r = (int64_t) (test_rand_bits() >> (64 - bits));
+  return (test_rand() & 1) ? -r : r;
+}
+
+static double rand_uniform(void)
+{
+  return (double) (test_rand() >> 11) / (1ull << 53);
+}
+
+static int64_t fixed(double x)
+{
+  return (int64_t) llround(ldexp(x, FBITS));
+}
+
+/* one sample through filter f@ */
+static int64_t filter_run(int64_t x)
+{
+  ubasic_set_variable(VAR('x'), (VARIABLE_TYPE) x);
+  ubasic_execute_statement(filter_step);
+  return ubasic_get_variable(VAR('y'));
+}
+
+/* distance in lsb between the output y and the exact sum s of products,
+   which has FBITS more fractional bits, saturated as the output is */
+static double filter_error(int64_t y, wide_t s)
+{
+  wide_t d, max = (wide_t) VARIABLE_TYPE_MAX << FBITS;
+
+  if (s > max)
+    s = max;
+  if (s < -max)
+    s = -max;
+  d = (wide_t) y * ((wide_t) 1 << FBITS) - s;
+  if (d < 0)
+    d = -d;
+  return ldexp((double) d, -FBITS);
+}
+
+/* coefficients b0 b1 b2 a1 a2 of a biquad section with poles at radius
+   r < 0.9, so that the gain stays below 100 */
+static void biquad_random(int64_t *c)
+{
+  double r = 0.3 + 0.6 * rand_uniform(), w = M_PI * rand_uniform();
+
+  c[0] = fixed(0.5 * rand_uniform() - 0.25);
+  c[1] = fixed(0.5 * rand_uniform() - 0.25);
+  c[2] = fixed(0.5 * rand_uniform() - 0.25);
+  c[3] = fixed(-2 * r * cos(w));
+  c[4] = fixed(r * r);
+}
+
+static void coefficients(int64_t *c, uint16_t n)
+{
+  uint16_t i;
+
+  ubasic_dim_arrayvariable(VAR('c'), n);
+  for (i = 0; i < n; i++)
+    ubasic_set_arrayvariable(VAR('c'), i + 1, (VARIABLE_TYPE) c[i]);
+}
+
+int main(void)
+{
+  int64_t c[MAX_TAPS], x[MAX_TAPS], y, h[4], in[STEPS], out[STEPS];
+  double err, e_fir = 0, e_biquad = 0;
+  uint32_t e_cascade = 0, e_init = 0;
+  uint16_t n, k, i, j, it;
+  wide_t s;
+  char what[40];
+  double t;
+
+  printf("filter, %d.%d\n", FIXEDPT_WBITS, FIXEDPT_FBITS);
+  ubasic_clear_variables();
+
+  /* FIR: coefficients up to 1, inputs that do not saturate the sum */
+  for (it = 0; it < 200; it++)
+  {
+    n = 1 + test_rand() % MAX_TAPS;
+    for (i = 0; i < n; i++)
+    {
+      c[i] = rand_value(FBITS);
+      x[i] = 0;
+    }
+    coefficients(c, n);
+    e_init += run("filter_init f@, c@");
+
+    for (k = 0; k < STEPS; k++)
+    {
+      memmove(x + 1, x, (n - 1) * sizeof(x[0]));
+      x[0] = rand_value(VBITS - 8);
+      y = filter_run(x[0]);
+      for (s = 0, i = 0; i < n; i++)
+        s += (wide_t) c[i] * x[i];
+      err = filter_error(y, s);
+      if (err > e_fir)
+        e_fir = err;
+    }
+  }
+  test_report("FIR, lsb", e_fir, 0.5);
+
+  /* single biquad sections, against the outputs they returned before */
+  for (it = 0; it < 500; it++)
+  {
+    biquad_random(c);
+    coefficients(c, 5);
+    e_init += run("filter_init f@, c@, biquad");
+    memset(h, 0, sizeof(h));
+
+    for (k = 0; k < STEPS; k++)
+    {
+      x[0] = rand_value(VBITS - 12);
+      y = filter_run(x[0]);
+      s = (wide_t) c[0] * x[0] + (wide_t) c[1] * h[0] + (wide_t) c[2] * h[1]
+          - (wide_t) c[3] * h[2] - (wide_t) c[4] * h[3];
+      err = filter_error(y, s);
+      if (err > e_biquad)
+        e_biquad = err;
+      h[1] = h[0];
+      h[0] = x[0];
+      h[3] = h[2];
+      h[2] = y;
+    }
+  }
+  test_report("biquad, lsb", e_biquad, 0.5);
+
+  /* cascades, against their sections one after the other */
+  for (it = 0; it < 200; it++)
+  {
+    n = 2 + test_rand() % (MAX_SECTIONS - 1);
+    for (j = 0; j < n; j++)
+      biquad_random(c + 5 * j);
+    for (k = 0; k < STEPS; k++)
+      in[k] = out[k] = rand_value(VBITS - 20);
+
+    coefficients(c, 5 * n);
+    e_init += run("filter_init f@, c@, biquad");
+    for (k = 0; k < STEPS; k++)
+      in[k] = filter_run(in[k]);
+
+    for (j = 0; j < n; j++)
+    {
+      coefficients(c + 5 * j, 5);
+      e_init += run("filter_init f@, c@, biquad");
+      for (k = 0; k < STEPS; k++)
+        out[k] = filter_run(out[k]);
+    }
+    for (k = 0; k < STEPS; k++)
+      e_cascade += (in[k] != out[k]);
+  }
+  test_report("biquad cascade, wrong outputs", e_cascade, 0);
+
+  /* coefficients that are not sections, and a filter of itself */
+  host_quiet = 1;
+  ubasic_dim_arrayvariable(VAR('c'), 7);
+  e_init += !run("filter_init f@, c@, biquad");
+  e_init += !run("filter_init c@, c@");
+  host_quiet = 0;
+  test_report("filter_init, wrong errors", e_init, 0);
+
+  for (n = 4; n <= 16; n *= 4)
+  {
+    for (i = 0; i < n; i++)
+      c[i] = rand_value(FBITS);
+    coefficients(c, n);
+    run("filter_init f@, c@");
+    t = test_ns();
+    for (k = 0; k < 10000; k++)
+      filter_run(rand_value(VBITS - 8));
+    sprintf(what, "FIR, %d taps", n);
+    test_timing(what, t, 10000);
+  }
+  for (j = 0; j < 2; j++)
+    biquad_random(c + 5 * j);
+  coefficients(c, 10);
+  run("filter_init f@, c@, biquad");
+  t = test_ns();
+  for (k = 0; k < 10000; k++)
+    filter_run(rand_value(VBITS - 12));
+  test_timing("biquad, 2 sections", t, 10000);
+
+  return test_failed;
+}
@@ -0,0 +1,210 @@
+/*-
+ * Copyright (c) 2017-18, Marijan Kostrun <mkostrun@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * interp and polyval, run through the interpreter as a script would.
+ * interp gets tables of 1 to 64 increasing or decreasing breakpoints, plain
+ * or int16, and has to be within 1 lsb of the exact value on the line
+ * through the two points around x, taken as a fraction of 128 bit
+ * integers, and exact at and beyond the ends. polyval gets polynomials of
+ * degree 0 to 7 with coefficients up to 4 and x up to 1, and is compared
+ * with Horner's rule in long double: each of the n-1 products is rounded
+ * down once, and |x| <= 1 keeps the earlier errors from growing, so the
+ * error stays below n-1 lsb.
+ */
+
+#include "test.h"
+#include "ubasic.h"
+
+#define VAR(c)        ((c) - 'a')
+#define FBITS         FIXEDPT_FBITS
+#define VBITS         (8 * (int) sizeof(VARIABLE_TYPE))
+#define MAX_POINTS    64
+#define MAX_COEFFS    8
+
+typedef __int128 wide_t;
+
+static char interp_xy[] = "y = interp(x, u@, v@)";
+static char polyval_xc[] = "y = polyval(x, c@)";
+
+/* random value of up to bits bits and either sign */
+static int64_t rand_value(int bits)
+{
+  int64_t r = (int64_t) (test_rand_bits() >> (64 - bits));
+  return (test_rand() & 1) ? -r : r;
+}
+
+static int cmp_value(const void *a, const void *b)
+{
+  int64_t x = *(const int64_t *) a, y = *(const int64_t *) b;
+  return (x > y) - (x < y);
+}
+
+/* n values of up to about bits bits in increasing order: equal ones are
+   moved apart */
+static void rand_points(int64_t *p, uint16_t n, int bits)
+{
+  uint16_t i;
+
+  for (i = 0; i < n; i++)
+    p[i] = rand_value(bits);
+  qsort(p, n, sizeof(p[0]), cmp_value);
+  for (i = 1; i < n; i++)
+    if (p[i] <= p[i-1])
+      p[i] = p[i-1] + 1 + (test_rand() & 15);
+}
+
+static int64_t interp_run(int64_t x)
+{
+  ubasic_set_variable(VAR('x'), (VARIABLE_TYPE) x);
+  ubasic_execute_statement(interp_xy);
+  return ubasic_get_variable(VAR('y'));
+}
+
+/* distance in lsb between y and the value at x on the line through
+   (x0, y0) and (x1, y1) */
+static double line_error(int64_t y, int64_t x, int64_t x0, int64_t y0, int64_t x1, int64_t y1)
+{
+  wide_t d = ((wide_t) y - y0) * (x1 - x0) - ((wide_t) y1 - y0) * (x - x0);
+  if (d < 0)
+    d = -d;
+  return (double) d / fabs((double) x1 - (double) x0);
+}
+
+int main(void)
+{
+  int64_t xs[MAX_POINTS], ys[MAX_POINTS], c[MAX_COEFFS], x, y;
+  double err, e_in = 0, e_ends = 0, e_poly = 0;
+  long double r;
+  uint16_t n, i, k, it;
+  uint8_t down, packed;
+  double t;
+
+  printf("interp, polyval, %d.%d\n", FIXEDPT_WBITS, FIXEDPT_FBITS);
+  ubasic_clear_variables();
+
+  for (it = 0; it < 2000; it++)
+  {
+    n = 1 + test_rand() % MAX_POINTS;
+    down = test_rand() & 1;
+    packed = (test_rand() % 4 == 0);
+
+    /* int16 breakpoints are whole numbers, as from an ADC */
+    rand_points(xs, n, (packed) ? 12 : VBITS - 4);
+    if (down)
+      for (i = 0; i < n; i++)
+        xs[i] = -xs[i];
+    ubasic_dim_typedarrayvariable(VAR('u'), n, 0, (packed) ? ARRAY_TYPE_INT16 : ARRAY_TYPE_VARIABLE);
+    ubasic_dim_arrayvariable(VAR('v'), n);
+    for (i = 0; i < n; i++)
+    {
+      if (packed)
+        xs[i] *= (int64_t) 1 << FBITS;
+      ys[i] = rand_value(VBITS - 4);
+      ubasic_set_arrayvariable(VAR('u'), i + 1, (VARIABLE_TYPE) xs[i]);
+      ubasic_set_arrayvariable(VAR('v'), i + 1, (VARIABLE_TYPE) ys[i]);
+    }
+
+    for (k = 0; k < 50; k++)
+    {
+      /* between, at and beyond the breakpoints */
+      i = test_rand() % n;
+      x = xs[i];
+      if (k & 1)
+        x += rand_value((packed) ? FBITS + 12 : VBITS - 4);
+      y = interp_run(x);
+
+      if ( (down) ? (x >= xs[0]) : (x <= xs[0]) )
+      {
+        err = fabs((double) y - (double) ys[0]);
+        if (err > e_ends)
+          e_ends = err;
+        continue;
+      }
+      if ( (down) ? (x <= xs[n-1]) : (x >= xs[n-1]) )
+      {
+        err = fabs((double) y - (double) ys[n-1]);
+        if (err > e_ends)
+          e_ends = err;
+        continue;
+      }
+      for (i = 1; (down) ? (xs[i] > x) : (xs[i] < x); i++)
+        ;
+      err = line_error(y, x, xs[i-1], ys[i-1], xs[i], ys[i]);
+      if (err > e_in)
+        e_in = err;
+    }
+  }
+  test_report("interp, lsb", e_in, 1);
+  test_report("interp, ends, lsb", e_ends, 0);
+
+  for (it = 0; it < 20000; it++)
+  {
+    n = 1 + test_rand() % MAX_COEFFS;
+    ubasic_dim_arrayvariable(VAR('c'), n);
+    for (i = 0; i < n; i++)
+    {
+      c[i] = rand_value(FBITS + 2);
+      ubasic_set_arrayvariable(VAR('c'), i + 1, (VARIABLE_TYPE) c[i]);
+    }
+    x = rand_value(FBITS + 1) / 2;
+    ubasic_set_variable(VAR('x'), (VARIABLE_TYPE) x);
+    ubasic_execute_statement(polyval_xc);
+
+    for (r = 0, i = 0; i < n; i++)
+      r = r * ldexpl(x, -FBITS) + c[i];
+    err = fabsl(r - ubasic_get_variable(VAR('y')));
+    if (n > 1)
+      err /= n - 1;
+    if (err > e_poly)
+      e_poly = err;
+  }
+  test_report("polyval, lsb per product", e_poly, 1);
+
+  n = 16;
+  rand_points(xs, n, VBITS - 4);
+  ubasic_dim_arrayvariable(VAR('u'), n);
+  ubasic_dim_arrayvariable(VAR('v'), n);
+  for (i = 0; i < n; i++)
+  {
+    ubasic_set_arrayvariable(VAR('u'), i + 1, (VARIABLE_TYPE) xs[i]);
+    ubasic_set_arrayvariable(VAR('v'), i + 1, (VARIABLE_TYPE) rand_value(VBITS - 4));
+  }
+  t = test_ns();
+  for (k = 0; k < 10000; k++)
+    interp_run(xs[k % n] + k);
+  test_timing("interp, 16 points", t, 10000);
+
+  ubasic_dim_arrayvariable(VAR('c'), 6);
+  for (i = 0; i < 6; i++)
+    ubasic_set_arrayvariable(VAR('c'), i + 1, (VARIABLE_TYPE) rand_value(FBITS + 2));
+  t = test_ns();
+  for (k = 0; k < 10000; k++)
+    ubasic_execute_statement(polyval_xc);
+  test_timing("polyval, degree 5", t, 10000);
+
+  return test_failed;
+}
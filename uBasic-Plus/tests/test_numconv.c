@@ -0,0 +1,146 @@
+/*-
+ * Copyright (c) 2017-18, Marijan Kostrun <mkostrun@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * numconv.c against sprintf and fixedpt_str(): decimal and hex text of the
+ * edge values and of random numbers of every length, and the fixed point
+ * text, with the decimals print uses and with the most the format has, of
+ * every number up to +/-2^20 lsb, of the edge values and of random ones.
+ * The fixed point text of the most negative number, which fixedpt_str()
+ * gets wrong, is checked on its own. Times are per conversion.
+ */
+
+#include "test.h"
+#include "numconv.h"
+
+#define TEST_RANDOM   2000000
+#define TEST_SWEEP    (1 << 20)
+
+#define NUMCONV_INT_MAX   ((NUMCONV_INT) (~(NUMCONV_UINT) 0 >> 1))
+#define NUMCONV_INT_MIN   (-NUMCONV_INT_MAX - 1)
+
+static uint32_t errors;
+
+static void check(const char *what, const char *got, const char *want)
+{
+  if (strcmp(got, want) == 0)
+    return;
+  if (errors++ < 10)
+    printf("%s: \"%s\", expected \"%s\"\n", what, got, want);
+}
+
+static void check_int(NUMCONV_INT v)
+{
+  char got[NUMCONV_MAXLEN], want[NUMCONV_MAXLEN];
+
+  numconv_dec(got, v);
+  sprintf(want, "%lld", (long long) v);
+  check("dec", got, want);
+
+  numconv_hex(got, (NUMCONV_UINT) v);
+  sprintf(want, "%llx", (unsigned long long) (NUMCONV_UINT) v);
+  check("hex", got, want);
+}
+
+static const uint8_t decimals[] = { FIXEDPT_FBITS / 3, (FIXEDPT_FBITS * 3 + 9) / 10 };
+
+static void check_fixedpt(fixedpt v)
+{
+  char got[NUMCONV_MAXLEN + 8], want[NUMCONV_MAXLEN + 8];
+  uint8_t i;
+
+  for (i = 0; i < sizeof(decimals); i++)
+  {
+    numconv_fixedpt(got, v, decimals[i]);
+    fixedpt_str(v, want, decimals[i]);
+    check("fixedpt", got, want);
+  }
+}
+
+int main(void)
+{
+  static const NUMCONV_INT edges[] = { 0, 1, -1, 9, 10, -10, 99, 100, -100,
+    NUMCONV_INT_MAX, NUMCONV_INT_MAX - 1, NUMCONV_INT_MIN + 1, NUMCONV_INT_MIN };
+  char got[NUMCONV_MAXLEN + 8], want[NUMCONV_MAXLEN + 8];
+  uint32_t i, n = 0;
+  uint64_t v;
+  double t;
+
+  printf("numconv, %d.%d\n", FIXEDPT_WBITS, FIXEDPT_FBITS);
+
+  for (i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+    check_int(edges[i]);
+  for (i = 0; i < TEST_RANDOM; i++)
+    check_int((NUMCONV_INT) test_rand_signed());
+  test_report("dec and hex, mismatches", errors, 0);
+
+  errors = 0;
+  for (i = 1; i < sizeof(edges) / sizeof(edges[0]) - 1; i++)
+    check_fixedpt(edges[i]);
+  for (i = 0; i <= 2 * TEST_SWEEP; i++)
+    check_fixedpt((fixedpt) i - TEST_SWEEP);
+  for (i = 0; i < TEST_RANDOM; i++)
+    if ((fixedpt) (v = test_rand_signed()) != (fixedpt) NUMCONV_INT_MIN)
+      check_fixedpt((fixedpt) v);
+
+  // -2^(FIXEDPT_WBITS-1), a whole number
+  numconv_fixedpt(got, (fixedpt) NUMCONV_INT_MIN, decimals[0]);
+  sprintf(want, "-%llu", 1ull << (FIXEDPT_WBITS - 1));
+  check("fixedpt", got, want);
+  test_report("fixedpt, mismatches", errors, 0);
+
+  // time per conversion, against what print used before numconv
+  t = test_ns();
+  for (i = 0; i < TEST_RANDOM; i++)
+    n += numconv_dec(got, (NUMCONV_INT) test_rand_bits());
+  test_timing("dec", t, TEST_RANDOM);
+  t = test_ns();
+  for (i = 0; i < TEST_RANDOM; i++)
+    n += sprintf(got, "%lld", (long long) (NUMCONV_INT) test_rand_bits());
+  test_timing("sprintf %lld", t, TEST_RANDOM);
+  t = test_ns();
+  for (i = 0; i < TEST_RANDOM; i++)
+    n += numconv_hex(got, (NUMCONV_UINT) test_rand_bits());
+  test_timing("hex", t, TEST_RANDOM);
+  t = test_ns();
+  for (i = 0; i < TEST_RANDOM; i++)
+    n += sprintf(got, "%llx", (unsigned long long) (NUMCONV_UINT) test_rand_bits());
+  test_timing("sprintf %llx", t, TEST_RANDOM);
+  t = test_ns();
+  for (i = 0; i < TEST_RANDOM; i++)
+    n += numconv_fixedpt(got, (fixedpt) test_rand_bits(), decimals[0]);
+  test_timing("fixedpt", t, TEST_RANDOM);
+  t = test_ns();
+  for (i = 0; i < TEST_RANDOM; i++)
+  {
+    fixedpt_str((fixedpt) test_rand_bits(), got, decimals[0]);
+    n += got[0];
+  }
+  test_timing("fixedpt_str", t, TEST_RANDOM);
+  test_sink = n;
+
+  return test_failed;
+}
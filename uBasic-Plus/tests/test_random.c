@@ -0,0 +1,125 @@
+/*-
+ * Copyright (c) 2017-18, Marijan Kostrun <mkostrun@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * RandomUInt32() and RandomSeed() of hardware/random.c, built without a
+ * board so that they start from RANDOM_FIXED_SEED, against xoshiro128**
+ * as published by Blackman and Vigna, seeded through splitmix32: the same
+ * numbers from the same seed, the top bits for fewer than 32 bits, and
+ * the mean of uniform numbers.
+ */
+
+#include "test.h"
+#include "config.h"
+#include "random.h"
+
+/* the seed random.c takes without a board, unless config.h sets one */
+#if !defined(RANDOM_FIXED_SEED)
+#define RANDOM_FIXED_SEED 0x2545F491
+#endif
+
+#define RANDOM_OUTPUTS  300000
+#define RANDOM_MEAN_N   1000000
+
+static uint32_t ref_s[4];
+
+static uint32_t ref_rotl(uint32_t x, int k)
+{
+  return (x << k) | (x >> (32 - k));
+}
+
+static uint32_t ref_next(void)
+{
+  uint32_t result = ref_rotl(ref_s[1] * 5, 7) * 9;
+  uint32_t t = ref_s[1] << 9;
+
+  ref_s[2] ^= ref_s[0];
+  ref_s[3] ^= ref_s[1];
+  ref_s[1] ^= ref_s[2];
+  ref_s[0] ^= ref_s[3];
+  ref_s[2] ^= t;
+  ref_s[3] = ref_rotl(ref_s[3], 11);
+  return result;
+}
+
+static void ref_seed(uint32_t z)
+{
+  uint32_t x;
+  int i;
+
+  for (i = 0; i < 4; i++)
+  {
+    x = (z += 0x9e3779b9);
+    x = (x ^ (x >> 16)) * 0x85ebca6b;
+    x = (x ^ (x >> 13)) * 0xc2b2ae35;
+    ref_s[i] = x ^ (x >> 16);
+  }
+}
+
+int main(void)
+{
+  uint32_t i, bad = 0, first[4];
+  uint8_t size;
+  double sum = 0, t;
+
+  printf("random, seed 0x%08x\n", (unsigned) RANDOM_FIXED_SEED);
+
+  /* the first call seeds itself */
+  ref_seed(RANDOM_FIXED_SEED);
+  for (i = 0; i < RANDOM_OUTPUTS; i++)
+    bad += (RandomUInt32(32) != ref_next());
+  test_report("outputs, mismatches", bad, 0);
+
+  for (i = 0, bad = 0; i < RANDOM_OUTPUTS; i++)
+  {
+    size = 1 + i % 31;
+    bad += (RandomUInt32(size) != (ref_next() >> (32 - size)));
+  }
+  test_report("1 to 31 bits, mismatches", bad, 0);
+
+  RandomSeed(0);
+  for (i = 0; i < 4; i++)
+    first[i] = RandomUInt32(32);
+  RandomSeed(0);
+  for (i = 0, bad = 0; i < 4; i++)
+    bad += (RandomUInt32(32) != first[i]);
+  RandomSeed(12345);
+  ref_seed(12345);
+  for (i = 0; i < RANDOM_OUTPUTS; i++)
+    bad += (RandomUInt32(32) != ref_next());
+  test_report("seeded again, mismatches", bad, 0);
+
+  for (i = 0; i < RANDOM_MEAN_N; i++)
+    sum += RandomUInt32(24);
+  test_report("mean of 24 bit uniforms - 1/2", fabs(ldexp(sum / RANDOM_MEAN_N, -24) - 0.5), 2e-3);
+
+  t = test_ns();
+  for (i = 0; i < RANDOM_MEAN_N; i++)
+    test_sink += RandomUInt32(32);
+  test_timing("RandomUInt32", t, RANDOM_MEAN_N);
+
+  return test_failed;
+}
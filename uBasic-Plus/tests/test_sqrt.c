@@ -0,0 +1,95 @@
+/*-
+ * Copyright (c) 2017-18, Marijan Kostrun <mkostrun@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * fixedpt_sqrt against the exact root of A * 2^FBITS, rounded to nearest:
+ * every argument below 2^22, the largest ones and random ones of random
+ * magnitude, and -1 for negative arguments. With EXHAUSTIVE set in the
+ * environment, 24.8 and 22.10 go through all 2^31 arguments instead.
+ */
+
+#include "test.h"
+#include "fixedptc.h"
+
+#define SQRT_ALL     (1 << 22)
+#define SQRT_RANDOM  4000000
+
+/* nearest root of A * 2^FBITS */
+static fixedpt sqrt_exact(fixedpt A)
+{
+  fixedptud n = (fixedptud) A << FIXEDPT_FBITS, s;
+
+  s = (fixedptud) sqrtl((long double) n);
+  while (s * s > n)
+    s--;
+  while ((s + 1) * (s + 1) <= n)
+    s++;
+  return (fixedpt) ((n - s * s > s) ? s + 1 : s);
+}
+
+int main(void)
+{
+  fixedpt a, max = (fixedpt) ((fixedptu) -1 >> 1), s = 0;
+  fixedptu i, last = SQRT_ALL;
+  uint32_t bad = 0;
+  double t;
+
+  printf("sqrt, %d.%d\n", FIXEDPT_WBITS, FIXEDPT_FBITS);
+
+#if FIXEDPT_BITS == 32
+  if (getenv("EXHAUSTIVE"))
+    last = (fixedptu) max + 1;
+#endif
+  for (i = 0; i < last; i++)
+    bad += (fixedpt_sqrt((fixedpt) i) != sqrt_exact((fixedpt) i));
+  for (i = 0; i < SQRT_ALL; i++)
+    bad += (fixedpt_sqrt(max - (fixedpt) i) != sqrt_exact(max - (fixedpt) i));
+  for (i = 0; i < SQRT_RANDOM; i++)
+  {
+    a = (fixedpt) (test_rand_bits() >> (64 - FIXEDPT_BITS + 1));
+    bad += (fixedpt_sqrt(a) != sqrt_exact(a));
+  }
+  test_report(last > SQRT_ALL ? "all arguments, mismatches" : "arguments, mismatches", bad, 0);
+
+  for (i = 0, bad = 0; i < SQRT_RANDOM; i++)
+  {
+    a = (fixedpt) (test_rand() | ((fixedptu) 1 << (FIXEDPT_BITS - 1)));
+    bad += (fixedpt_sqrt(a) != -1);
+  }
+  test_report("negative, mismatches", bad, 0);
+
+  t = test_ns();
+  for (i = 0; i < SQRT_ALL; i++)
+    s += fixedpt_sqrt(max - (fixedpt) i);
+  test_timing("large arguments", t, SQRT_ALL);
+  t = test_ns();
+  for (i = 0; i < SQRT_ALL; i++)
+    s += fixedpt_sqrt((fixedpt) i);
+  test_timing("arguments below 2^22 lsb", t, SQRT_ALL);
+  test_sink = s;
+
+  return test_failed;
+}
@@ -0,0 +1,104 @@
+/*-
+ * Copyright (c) 2017-18, Marijan Kostrun <mkostrun@gmail.com>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ */
+
+/*
+ * sin, cos and tan of fixedptc.h against libm over [-40, 40] rad: every
+ * value in 24.8 and 22.10, about 4M evenly spaced values in 32.32. Built
+ * once for each of the polynomial, FIXEDPT_TRIG_TABLE and
+ * FIXEDPT_TRIG_CORDIC. tan is checked where |cos| >= 1/4, which keeps the
+ * polynomial tan away from its division by zero.
+ */
+
+#include "test.h"
+#include "fixedptc.h"
+
+#define TRIG_RANGE  40
+
+/* the bounds: lsb of sin and cos, lsb of tan, and the error of the method
+   itself, which shows in the 32 fraction bits of 32.32 */
+#if defined(FIXEDPT_TRIG_TABLE)
+#define TRIG_NAME     "table"
+#define TRIG_LSB      0.5
+#define TRIG_TAN_LSB  1
+#define TRIG_ERR      2e-5      /* Q15 entries and the interpolation */
+#elif defined(FIXEDPT_TRIG_CORDIC)
+#define TRIG_NAME     "cordic"
+#define TRIG_LSB      0.5
+#define TRIG_TAN_LSB  1
+#define TRIG_ERR      3.5e-5
+#else
+#define TRIG_NAME     "polynomial"
+#define TRIG_LSB      16
+#define TRIG_TAN_LSB  256
+#define TRIG_ERR      2e-4
+#endif
+
+static double trig_lsb(fixedpt v, double ref)
+{
+  return fabs((double) v - ldexp(ref, FIXEDPT_FBITS));
+}
+
+int main(void)
+{
+  fixedpt a, last = fixedpt_fromint(TRIG_RANGE);
+  fixedpt step = (last >> 21) ? (last >> 21) : 1;
+  double x, err, err_sin = 0, err_cos = 0, err_tan = 0, bound, t;
+  uint32_t n = 0;
+  fixedpt s = 0;
+
+  printf("trig, %s, %d.%d\n", TRIG_NAME, FIXEDPT_WBITS, FIXEDPT_FBITS);
+
+  for (a = -last; a <= last; a += step)
+  {
+    x = ldexp((double) a, -FIXEDPT_FBITS);
+    err = trig_lsb(fixedpt_sin(a), sin(x));
+    if (err > err_sin)
+      err_sin = err;
+    err = trig_lsb(fixedpt_cos(a), cos(x));
+    if (err > err_cos)
+      err_cos = err;
+    if (fabs(cos(x)) >= 0.25)
+    {
+      err = trig_lsb(fixedpt_tan(a), tan(x));
+      if (err > err_tan)
+        err_tan = err;
+    }
+  }
+
+  bound = TRIG_LSB + ldexp(TRIG_ERR, FIXEDPT_FBITS);
+  test_report("sin, lsb", err_sin, bound);
+  test_report("cos, lsb", err_cos, bound);
+  /* tan is up to 4 and its slope up to 16 where it is checked */
+  test_report("tan, |cos| >= 1/4, lsb", err_tan, TRIG_TAN_LSB + 32 * ldexp(TRIG_ERR, FIXEDPT_FBITS));
+
+  t = test_ns();
+  for (a = -last; a <= last; a += step, n++)
+    s += fixedpt_sin(a);
+  test_sink = s;
+  test_timing("sin", t, n);
+
+  return test_failed;
+}